@@ -1,5 +1,9 @@
 #include "cGA.h"
 
+#include <algorithm>
+
+#include <omp.h>
+
 using namespace arg;
 
 cGA::cGA()
@@ -100,12 +104,12 @@ void cGA::MigrateImpl(unsigned int worst_idx, unsigned int best_idx, const bool
 		{
 			dbg << "The fitness of new chromosome and best chromosome is the same and they are probably identical."
 					<< "New chromosome will not be added to the population.\n";
-			delete mChromosome;
+			mChromosome->Release();
 		}
 		else
 		{
 			dbg << "Adding chromosome to the population.\n";
-			delete mSelected;
+			m_Population[worst_idx]->Release();
 			m_Population[worst_idx] = mChromosome;
 			SortInOne(worst_idx);
 		}
@@ -113,12 +117,18 @@ void cGA::MigrateImpl(unsigned int worst_idx, unsigned int best_idx, const bool
 	else
 	{
 		dbg << "Removing chromosome from the GA.\n";
-		delete mChromosome;
+		mChromosome->Release();
 	}
 }
 
 void cGA::Migrate(const bool prevent_stagnation)
 {
+	if (m_MigrationType == cGA::GENERATIONAL)
+	{
+		MigrateGenerational(prevent_stagnation);
+		return;
+	}
+
 	int idx = m_Minimize ? 0 : m_Population.Count() - 1;
 	int best_idx = m_Minimize ? m_Population.Count() - 1 : 0;
 	dbg << "Migration idx " << idx << " migration best_idx " << best_idx << ".\n";
@@ -131,11 +141,119 @@ void cGA::Migrate(const bool prevent_stagnation)
 void cGA::ComputeChildFitness(void)
 {
 	dbg << "Preparing to compute child fitness.\n";
-	const double fit1 = m_Son->ComputeFitness();
-	const double fit2 = m_Daughter->ComputeFitness();
+	double fit1 = 0, fit2 = 0;
+
+	// a child has to beat the worst individual to enter the population, the replacement only
+	// raises that threshold, so the evaluation may stop once the child cannot get above it
+	const bool bounded = (m_MigrationType == cGA::STEADY_STATE && !m_Minimize);
+	const double threshold = m_Population[m_Population.Count() - 1]->Fitness();
+
+	// the children are independent, evaluate them concurrently if threads are available
+	// and the GA does not already run in a parallel region
+	#pragma omp parallel sections if(omp_get_level() == 0)
+	{
+		#pragma omp section
+		fit1 = bounded ? m_Son->ComputeFitnessBounded(threshold) : m_Son->ComputeFitness();
+		#pragma omp section
+		fit2 = bounded ? m_Daughter->ComputeFitnessBounded(threshold) : m_Daughter->ComputeFitness();
+	}
 	dbg << "Child fitness computed: " << fit1 << " " << fit2 << ".\n";
 }
 
+/**
+ * Breeds a batch of lambda offspring from the current population.
+ * Parents are selected, recombined and mutated pair by pair (serially, so the results
+ * depend only on the seed) and the children are collected in m_Offspring.
+ */
+void cGA::Breed(const unsigned int lambda, const double pC, const double pM)
+{
+	m_Offspring.ClearCount();
+
+	while (m_Offspring.Count() < lambda)
+	{
+		Select();
+		Recombine(pC);
+		Mutate(pM);
+
+		m_Offspring.Append(m_Son);
+		if (m_Offspring.Count() < lambda)
+		{
+			m_Offspring.Append(m_Daughter);
+		}
+		else
+		{
+			m_Daughter->Release();
+		}
+	}
+	m_Son = m_Daughter = NULL;
+	dbg << "Bred " << m_Offspring.Count() << " offspring.\n";
+}
+
+/**
+ * Evaluates the whole batch of offspring. The individuals are independent, so the
+ * batch is spread over all available threads.
+ */
+void cGA::ComputeOffspringFitness(void)
+{
+	const int count = m_Offspring.Count();
+
+	#pragma omp parallel for schedule(dynamic) if(omp_get_level() == 0)
+	for (int i = 0; i < count; i++)
+	{
+		m_Offspring[i]->ComputeFitness();
+	}
+	dbg << "Offspring fitness computed.\n";
+}
+
+/**
+ * (mu, lambda) replacement with elitism. The best individual of the population survives,
+ * the remaining places are taken by the best offspring. If there are fewer offspring than
+ * places, only the worst individuals are replaced.
+ */
+void cGA::MigrateGenerational(const bool prevent_stagnation)
+{
+	const bool minimize = m_Minimize;
+	std::sort(m_Offspring.Begin(), m_Offspring.End(), [minimize](const cIndividual * a, const cIndividual * b)
+	{
+		return minimize ? a->Fitness() < b->Fitness() : a->Fitness() > b->Fitness();
+	});
+
+	const unsigned int best_idx = m_Minimize ? m_Population.Count() - 1 : 0;
+	const unsigned int places = m_Population.Count() - 1;
+	cIndividual * elite = m_Population[best_idx];
+
+	unsigned int replaced = 0;
+	for (unsigned int i = 0; i < m_Offspring.Count(); i++)
+	{
+		cIndividual * mChromosome = m_Offspring[i];
+
+		if (replaced < places && !(prevent_stagnation && elite->Equals(*mChromosome)))
+		{
+			// the population is sorted, replace from the worst end
+			const unsigned int idx = m_Minimize ? replaced : places - replaced;
+			m_Population[idx]->Release();
+			m_Population[idx] = mChromosome;
+			replaced++;
+		}
+		else
+		{
+			mChromosome->Release();
+		}
+	}
+	m_Offspring.ClearCount();
+
+	dbg << "Replaced " << replaced << " individuals.\n";
+	SortPopulation();
+}
+
+void cGA::Immigrate(cIndividual * mChromosome)
+{
+	int idx = m_Minimize ? 0 : m_Population.Count() - 1;
+	int best_idx = m_Minimize ? m_Population.Count() - 1 : 0;
+	dbg << "Immigrating chromosome to the population.\n";
+	MigrateImpl(idx, best_idx, false, mChromosome);
+}
+
 void cGA::SortPopulation(void)
 {
 	cIndividual * mHelp;
@@ -317,9 +435,15 @@ void cGA::ShuffleImpl(void)
 
 cGA::~cGA(void)
 {
+	for (unsigned int i = 0; i < m_Offspring.Count(); i++)
+	{
+		m_Offspring[i]->Release();
+	}
+	m_Offspring.Clear();
+
 	for (unsigned int i = 0; i < m_Population.Count(); i++)
 	{
-		delete m_Population[i];
+		m_Population[i]->Release();
 	}
 	m_Population.Clear();
 }
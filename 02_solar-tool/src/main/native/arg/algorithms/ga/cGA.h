@@ -13,6 +13,8 @@
  *	- abstractized for AmphorA core library, 25-7-2007, pkromer
  * 	- doxy comments, 26-07-2007, pkromer (non-functional change)
  *  - removed some problems, 12-2009, pkromer
+ *  - generational mode with batch offspring evaluation, 10-2026, agent
+ *  - bounded evaluation of the steady-state children, 10-2026, agent
  *
  */
 #ifndef __CGA__
@@ -50,6 +52,7 @@ namespace arg
 
 			const static unsigned int STEADY_STATE = 301;
 			const static unsigned int STEADY_STATE_REVERSE_FITNESS = 302;
+			const static unsigned int GENERATIONAL = 303;
 
 		protected:
 
@@ -57,6 +60,7 @@ namespace arg
 
 			unsigned int m_FirstParent, m_SecondParent; ///< Indexes of selected parents
 			cIndividual * m_Son, *m_Daughter; ///< Offspring chromosomes
+			cArrayConst<cIndividual*> m_Offspring; ///< A batch of offspring (generational mode)
 
 			/** Types of selection, mutation, crossover and migration. */
 			unsigned int m_SelectionType, m_MutationType, m_CrossoverType, m_MigrationType;
@@ -89,6 +93,14 @@ namespace arg
 			void Migrate(const bool prevent_stagnation = false);
 			void ComputeChildFitness(void);
 
+			/** Generational (batch) GA steps. */
+			void Breed(const unsigned int lambda, const double pC, const double pM);
+			virtual void ComputeOffspringFitness(void);
+			void MigrateGenerational(const bool prevent_stagnation = false);
+
+			/** Inserts an individual from outside (e.g. another island) in place of the worst one. */
+			void Immigrate(cIndividual * mChromosome);
+
 			/** Our own GA steps. */
 			void ShuffleImpl(void);
 
@@ -118,11 +130,15 @@ namespace arg
 			inline void Minimize(const bool val = true);
 			inline void Prevent(const bool val = true);
 			inline void Shuffle(const bool val = true);
+			/** \returns Whether the fitness is minimized. */
+			inline bool IsMinimizing(void) const;
 
 			/** \returns Best (maximum or minimum) fitness in the population. */
 			inline double BestFitness(void) const;
 			/** \returns Pointer to the best individual in the current population. */
 			inline cIndividual * WinnerPtr(void) const;
+			/** \returns Pointer to the rank-th best individual in the current population. */
+			inline cIndividual * IndividualPtr(const unsigned int rank) const;
 			/** Prints population statistics. */
 			void PrintPopulationInfo(const char * pattern = NULL);
 
@@ -205,11 +221,22 @@ namespace arg
 		return m_Population[best_idx];
 	}
 
+	inline cIndividual * cGA::IndividualPtr(const unsigned int rank) const
+	{
+		const unsigned int idx = m_Minimize ? m_Population.Count() - 1 - rank : rank;
+		return m_Population[idx];
+	}
+
 	inline void cGA::Minimize(const bool val)
 	{
 		m_Minimize = val;
 	}
 
+	inline bool cGA::IsMinimizing(void) const
+	{
+		return m_Minimize;
+	}
+
 	inline void cGA::Shuffle(const bool val)
 	{
 		m_Shuffle = val;
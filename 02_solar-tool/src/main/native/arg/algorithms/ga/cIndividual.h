@@ -11,6 +11,8 @@
  *	- initial version, 2007, pkromer
  *	- abstractized for AmphorA core library, 25-7-2007, pkromer
  * 	- doxygen comments, 26-07-2007, pkromer (non-functional change)
+ *	- bounded fitness evaluation (ComputeFitnessBounded), 10-2026, agent
+ *	- individuals are given back by Release, so they can be recycled, 10-2026, agent
  *
  */
 #ifndef __cINDIVIDUAL__
@@ -28,12 +30,19 @@ namespace arg
 
 		public:
 			virtual double ComputeFitness(void) = 0;
+			/**
+			 * Fitness evaluation that may stop as soon as the fitness provably cannot exceed the threshold
+			 * (maximization). The returned value is then an upper bound not above the threshold.
+			 */
+			virtual double ComputeFitnessBounded(const double threshold) {(void) threshold; return ComputeFitness();};
 			virtual void Print(void) const = 0;
 			virtual void Init(){};
 			virtual double Fitness() const {return m_Fitness;};
 			virtual void Mutate(const unsigned int, const double) = 0;
 			virtual void Crossover(const unsigned int, cIndividual&, const double) = 0;
 			virtual cIndividual * Clone(void) = 0;
+			/** Give up the individual, implementations may keep it for later clones instead of deleting it. */
+			virtual void Release(void) {delete this;};
 			virtual int Length(void){return -1;};
 			virtual bool Save(const char*){return false;};
 			virtual bool Equals(cIndividual & other) {return m_Fitness == other.Fitness();};
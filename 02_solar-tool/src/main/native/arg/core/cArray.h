@@ -11,7 +11,8 @@
  {																			}
  {																			}
  {    UPDATE HISTORY:														}
- {																			}
+ {    - geometric growth, Reserve, Swap, copy and move semantics			}
+ {    - items in a buffer given by the caller								}
  {																			}
  {***************************************************************************/
 
@@ -33,8 +34,14 @@ namespace arg
 	{
 		public:
 			cArrayConst();
+			// the items are kept in the buffer, which the array does not own, until they outgrow it
+			cArrayConst(T* Array, const unsigned int Size);
+			cArrayConst(const cArrayConst& other);
+			cArrayConst(cArrayConst&& other);
 			~cArrayConst();
 			const cArrayConst<T>& operator =(const cArrayConst& other);
+			// the other array gets the previous items
+			const cArrayConst<T>& operator =(cArrayConst&& other);
 			const cArrayConst<T>& operator =(const char * str);
 			inline T operator[](const unsigned int Index) const;
 			inline T& operator[](const unsigned int Index);
@@ -45,6 +52,9 @@ namespace arg
 			inline void ClearCount(void);
 			inline void Resize(const unsigned int Size, const bool Move = false);
 			inline void Resize(const unsigned int Size, const unsigned int Count);
+			// room for Size items without reallocation, the items are kept
+			inline void Reserve(const unsigned int Size);
+			inline void Swap(cArrayConst& other);
 			void Move(const T* Array, const unsigned int Count = 1);
 			unsigned int Add(const T* Array, const unsigned int Count = 1);
 			bool Delete(const unsigned int Index);
@@ -68,7 +78,10 @@ namespace arg
 			unsigned int m_Size;
 			unsigned int m_Count;
 			T* m_Array;
+			bool m_Static; ///< m_Array is the buffer of the caller
 			void m_Resize(const unsigned int Size, const bool Move);
+			// make room for Count items, the capacity at least doubles
+			inline void m_Grow(const unsigned int Count);
 	};
 
 	template<class T>
@@ -138,8 +151,30 @@ namespace arg
 
 	template<class T>
 	cArrayConst<T>::cArrayConst() :
-			m_Size(0), m_Count(0), m_Array(0)
+			m_Size(0), m_Count(0), m_Array(0), m_Static(false)
+	{
+	}
+
+	template<class T>
+	cArrayConst<T>::cArrayConst(T* Array, const unsigned int Size) :
+			m_Size(Size), m_Count(0), m_Array(Array), m_Static(true)
+	{
+	}
+
+	template<class T>
+	cArrayConst<T>::cArrayConst(const cArrayConst& other) :
+			m_Size(0), m_Count(0), m_Array(0), m_Static(false)
+	{
+		Move(other.m_Array, other.m_Count);
+	}
+
+	template<class T>
+	cArrayConst<T>::cArrayConst(cArrayConst&& other) :
+			m_Size(other.m_Size), m_Count(other.m_Count), m_Array(other.m_Array), m_Static(other.m_Static)
 	{
+		other.m_Size = other.m_Count = 0;
+		other.m_Array = 0;
+		other.m_Static = false;
 	}
 
 	template<class T>
@@ -158,6 +193,13 @@ namespace arg
 		return *this;
 	}
 
+	template<class T>
+	const cArrayConst<T>& cArrayConst<T>::operator =(cArrayConst&& other)
+	{
+		Swap(other);
+		return *this;
+	}
+
 	template<class T>
 	T cArrayConst<T>::operator[](const unsigned int Index) const
 	{
@@ -213,12 +255,40 @@ namespace arg
 		m_Count = Count < m_Size ? Count : m_Size;
 	}
 
+	template<class T>
+	void cArrayConst<T>::Reserve(const unsigned int Size)
+	{
+		if (Size > m_Size)
+		{
+			m_Resize(Size, true);
+		}
+	}
+
+	template<class T>
+	void cArrayConst<T>::Swap(cArrayConst& other)
+	{
+		const unsigned int size = m_Size;
+		const unsigned int count = m_Count;
+		T* array = m_Array;
+		const bool is_static = m_Static;
+
+		m_Size = other.m_Size;
+		m_Count = other.m_Count;
+		m_Array = other.m_Array;
+		m_Static = other.m_Static;
+
+		other.m_Size = size;
+		other.m_Count = count;
+		other.m_Array = array;
+		other.m_Static = is_static;
+	}
+
 	template<class T>
 	void cArrayConst<T>::Move(const T* Array, const unsigned int Count)
 	{
-		if (m_Size <= Count)
+		if (Count > m_Size)
 		{
-			m_Resize(Count, false);
+			m_Resize(Count > 2 * m_Size ? Count : 2 * m_Size, false);
 		}
 		memcpy(m_Array, Array, sizeof(T) * Count);
 		m_Count = Count;
@@ -228,10 +298,7 @@ namespace arg
 	unsigned int cArrayConst<T>::Add(const T* Array, const unsigned int Count)
 	{
 		unsigned int iRet;
-		if (m_Count + Count >= m_Size)
-		{
-			m_Resize(m_Count + Count, true);
-		}
+		m_Grow(m_Count + Count);
 		iRet = m_Count;
 		if (Count == 1)
 		{
@@ -285,7 +352,7 @@ namespace arg
 	{
 		if (!(m_Count < m_Size))
 		{
-			m_Resize(m_Size + 1, true);
+			m_Grow(m_Size + 1);
 		}
 		m_Array[m_Count++] = Value;
 	}
@@ -314,12 +381,13 @@ namespace arg
 			{
 				memcpy(auxPtr, m_Array, sizeof(T) * (m_Count < mSize ? m_Count : mSize));
 			}
-			if (m_Array != 0)
+			if (m_Array != 0 && !m_Static)
 			{
 				delete[] m_Array;
 			}
 			m_Array = auxPtr;
 			m_Size = mSize;
+			m_Static = false;
 			if (m_Count > m_Size)
 			{
 				m_Count = m_Size;
@@ -327,12 +395,22 @@ namespace arg
 		}
 		else if (Size == 0)
 		{
-			if (m_Array != 0)
+			if (m_Array != 0 && !m_Static)
 			{
 				delete[] m_Array;
-				m_Array = 0;
 			}
+			m_Array = 0;
 			m_Size = m_Count = 0;
+			m_Static = false;
+		}
+	}
+
+	template<class T>
+	void cArrayConst<T>::m_Grow(const unsigned int Count)
+	{
+		if (Count > m_Size)
+		{
+			m_Resize(Count > 2 * m_Size ? Count : 2 * m_Size, true);
 		}
 	}
 
@@ -348,7 +426,7 @@ namespace arg
 	{
 		//std::cout << " aa " << count << " " << m_Count << ", " << idx << std::endl;
 		unsigned int move_count = m_Count - idx;
-		m_Resize(m_Count + count, true);
+		m_Grow(m_Count + count);
 		m_Count += count;
 		//std::cout << "a " << move_count << std::endl;
 		memmove(&m_Array[idx + count], &m_Array[idx], sizeof(T)*(move_count));
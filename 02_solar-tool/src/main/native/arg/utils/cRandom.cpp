@@ -9,7 +9,7 @@
 
 namespace arg
 {
-	std::unique_ptr<cRandom> cStaticRandom::m_Generator(std::unique_ptr<cRandom>(new cMersenneTwister(THREADSAFE_SEED)));
+	thread_local std::unique_ptr<cRandom> cStaticRandom::m_Generator(std::unique_ptr<cRandom>(new cMersenneTwister(THREADSAFE_SEED)));
 
 	cRandom* cRandom::GetInstance(const t_RngType rng_type)
 	{
@@ -89,4 +89,11 @@ namespace arg
 	{
 		m_Generator.reset(rng);
 	}
+
+	cRandom* cStaticRandom::SwapStaticGenerator(cRandom* rng)
+	{
+		cRandom * previous = m_Generator.release();
+		m_Generator.reset(rng);
+		return previous;
+	}
 }
@@ -75,7 +75,8 @@ namespace arg
 	 *
 	 * Provides static utility methods for pseudo rng. Uses a \b static cMerseneTwister
 	 * in background. I.e. every component that uses this class gets pseudo random
-	 * numbers from the same source.
+	 * numbers from the same source. The source is thread local, so threads never
+	 * share generator state.
 	 *
 	 * \author Pavel Krömer (pkromer), (c) 2005 - 2013
 	 *
@@ -84,11 +85,12 @@ namespace arg
 	 *		- 2006,		pkromer, 	more methods
 	 *		- 2011-02,	pkromer,	changed to a facade to a static cMersenneTwister
 	 *		- 2011-11,	pkromer,	Support for mersenne twister and ranlux
+	 *		- 2026-10,	agent,		thread local generator, SwapStaticGenerator for per-task streams
 	 *
 	 */
 	class cStaticRandom
 	{
-			static std::unique_ptr<cRandom> m_Generator;
+			static thread_local std::unique_ptr<cRandom> m_Generator;
 
 		public:
 			inline static void Seed(const unsigned int); 			///< Seed with some value.
@@ -119,6 +121,16 @@ namespace arg
 			 * \param[in] rng	- pointer to PRNG instance. Instance will be freed by cStaticRandom.
 			 */
 			static void SetStaticGenerator(cRandom* rng);
+
+			/**
+			 * \brief Replaces the generator of the calling thread without freeing it.
+			 *
+			 * Allows a task (e.g. an island) to carry its own random stream from thread to thread.
+			 *
+			 * \param[in] rng	- the new generator. The caller keeps the ownership.
+			 * \return the previous generator. The caller takes the ownership.
+			 */
+			static cRandom* SwapStaticGenerator(cRandom* rng);
 	};
 
 	inline void cStaticRandom::Seed(const unsigned int seed)
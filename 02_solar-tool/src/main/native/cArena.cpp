@@ -0,0 +1,55 @@
+#include "cArena.h"
+
+cArena::cArena(void) : m_Block(NULL), m_Size(0), m_Used(0), m_Demand(0)
+{
+}
+
+void * cArena::Alloc(size_t bytes)
+{
+	bytes = (bytes + ALIGN - 1) & ~(ALIGN - 1);
+	m_Demand += bytes;
+
+	if (m_Used + bytes <= m_Size)
+	{
+		void * ptr = m_Block + m_Used;
+		m_Used += bytes;
+		return ptr;
+	}
+
+	char * spill = new char[bytes];
+	m_Spill.Append(spill);
+	return spill;
+}
+
+void cArena::Reset(void)
+{
+	for (unsigned int i = 0; i < m_Spill.Count(); i++)
+	{
+		delete[] m_Spill[i];
+	}
+	m_Spill.ClearCount();
+
+	if (m_Demand > m_Size)
+	{
+		delete[] m_Block;
+		m_Block = new char[m_Demand];
+		m_Size = m_Demand;
+	}
+	m_Used = 0;
+	m_Demand = 0;
+}
+
+cArena & cArena::Local(void)
+{
+	static thread_local cArena arena;
+	return arena;
+}
+
+cArena::~cArena(void)
+{
+	for (unsigned int i = 0; i < m_Spill.Count(); i++)
+	{
+		delete[] m_Spill[i];
+	}
+	delete[] m_Block;
+}
@@ -0,0 +1,49 @@
+/**
+ * \class cArena
+ * \brief Bump allocator for the temporaries of the genetic operators.
+ *
+ * Crossover and mutation build offspring and random subtrees in short-lived arrays. Each
+ * thread has its own arena (Local), the memory is taken by moving a pointer and given back
+ * all at once by Reset, once per generation. A request the block cannot serve goes to the
+ * heap, Reset then frees it and grows the block, so after a few generations the operators
+ * do not touch the heap at all and the threads of the island model never contend for it.
+ */
+
+#ifndef CARENA_H_
+#define CARENA_H_
+
+#include <arg/core/cArray.h>
+
+#include <cstddef>
+
+class cArena
+{
+		const static size_t ALIGN = 16;
+
+		char * m_Block;
+		size_t m_Size;
+		size_t m_Used;
+		size_t m_Demand; ///< bytes asked for since the last reset
+
+		arg::cArrayConst<char*> m_Spill; ///< heap blocks of the requests that did not fit
+
+		cArena(const cArena&);
+		cArena& operator=(const cArena&);
+
+	public:
+		cArena(void);
+
+		/** \returns Uninitialized memory valid until the next Reset. */
+		void * Alloc(size_t bytes);
+		template<class T> T * Alloc(const unsigned int count) {return (T *) Alloc(sizeof(T) * count);};
+
+		/** Give back all the memory, the block grows to what was asked for since the last reset. */
+		void Reset(void);
+
+		/** \returns The arena of the calling thread. */
+		static cArena & Local(void);
+
+		~cArena(void);
+};
+
+#endif /* CARENA_H_ */
@@ -1,61 +1,119 @@
 #include "cForest.h"
+#include "cArena.h"
 #include <arg/utils/cRandom.h>
 
 #include <iostream>
 #include <iomanip>
 #include <cmath>
 
+#include <omp.h>
+
 using namespace std;
 using namespace arg;
 
+cArrayConst<cForest*> cForest::s_Pool;
+
 cForest::cForest(cData & data, cModel & model, t_FitnessType fit_type) :
-		m_Data(data), m_Model(model), m_FitnessType(fit_type)
+		m_Data(data), m_Model(model), m_FitnessType(fit_type), m_Checkpoints(NULL)
 {
 	m_Records = m_Data.Records();
 	m_Inputs = m_Data.Inputs();
 	m_Targets = m_Data.Targets();
 	m_RowLength = m_Inputs + m_Targets;
-	m_Estimates = new double[m_Records * m_Targets];
 	m_LeftOutIdx = m_Data.LeaveOutIdx();
 	m_Beta = m_Model.Beta();
 	m_MaxTreeInstructions = m_Model.MaxTreeInstructions();
 	GenenerateTestForest();
 }
 
-void cForest::RandEstimates(void)
+void cForest::GenenerateTestForest(void)
 {
-	for (unsigned int i = 0; i < m_Records * m_Targets; i++)
+	m_Forest.Clear();
+
+	t_Instruction separator;
+	separator.type = SEPARATOR_INSTRUCTION;
+
+	for (unsigned int i = 0; i < m_Targets; i++)
 	{
-		m_Estimates[i] = arg::cStaticRandom::Next(1);
+		cArrayConst<t_Instruction> tree = m_Model.RandomTree(m_Inputs, m_Targets);
+
+		m_Forest.Add(tree.GetArray(0), tree.Count());
+		m_Forest.Add(&separator);
 	}
+	Reindex();
 }
 
-void cForest::StealEstimates(void)
+void cForest::Reindex(void)
 {
-	for (unsigned int i = 0; i < m_Records; i++)
+	const unsigned int count = m_Forest.Count();
+
+	m_SubtreeLeft.Resize(count, count);
+	m_RuleEnd.ClearCount();
+
+	IndexRange(0, count);
+}
+
+void cForest::IndexRange(const unsigned int from, const unsigned int to)
+{
+	unsigned int rule_start = from;
+	unsigned int top = 0;
+
+	m_Roots.Resize(to - from, to - from);
+
+	// the operands of an instruction are the subtrees on the top of the stack, the first
+	// of them starts its subtree, NOOPs belong to no subtree
+	for (unsigned int i = from; i < to; i++)
 	{
-		double * targets = m_Data.Targets(i);
-		for (unsigned int j = 0; j < m_Targets; j++)
+		const int type = m_Forest[i].type;
+		unsigned int left = i;
+
+		if (type == SEPARATOR_INSTRUCTION)
+		{
+			m_RuleEnd.Append(i);
+			rule_start = i + 1;
+			top = 0;
+		}
+		else if (type != NOOP_INSTRUCTION)
 		{
-			m_Estimates[i * m_Targets + j] = targets[j] - 0.001;
+			const unsigned int arity = type / 100;
+
+			if (arity > top) // malformed rule, the subtree takes all before
+			{
+				left = rule_start;
+				top = 0;
+			}
+			else if (arity > 0)
+			{
+				top -= arity;
+				left = m_SubtreeLeft[m_Roots[top]];
+			}
+			m_Roots[top++] = i;
 		}
+		m_SubtreeLeft[i] = left;
 	}
 }
 
-void cForest::GenenerateTestForest(void)
+void cForest::ShiftIndex(const unsigned int from, const unsigned int removed, const unsigned int inserted)
 {
-	m_Forest.Clear();
+	const unsigned int count = m_SubtreeLeft.Count();
+	const unsigned int after = from + removed;
+	const unsigned int new_count = count - removed + inserted;
 
-	t_Instruction separator;
-	separator.type = SEPARATOR_INSTRUCTION;
-
-	for (unsigned int i = 0; i < m_Targets; i++)
+	// the subtrees after the replaced ones move, the ones before keep their place
+	for (unsigned int i = after; i < count; i++)
 	{
-		cArrayConst<t_Instruction> tree = m_Model.RandomTree(m_Inputs, m_Targets);
-
-		m_Forest.Add(tree.GetArray(0), tree.Count());
-		m_Forest.Add(&separator);
+		if (m_SubtreeLeft[i] >= after)
+			m_SubtreeLeft[i] = m_SubtreeLeft[i] - removed + inserted;
+	}
+	for (unsigned int i = 0; i < m_RuleEnd.Count(); i++)
+	{
+		if (m_RuleEnd[i] >= after)
+			m_RuleEnd[i] = m_RuleEnd[i] - removed + inserted;
 	}
+
+	m_SubtreeLeft.Reserve(new_count);
+	memmove(m_SubtreeLeft.GetArray(from + inserted), m_SubtreeLeft.GetArray(after), sizeof(unsigned int) * (count - after));
+	m_SubtreeLeft.Resize(m_SubtreeLeft.Size(), new_count);
 }
 
 bool cForest::ParseForest(char * str)
@@ -66,8 +124,6 @@ bool cForest::ParseForest(char * str)
 
 	m_Targets = 0;
 
-	delete[] m_Estimates;
-
 	while (token != NULL)
 	{
 		// cout << "> " << token << endl;
@@ -80,11 +136,10 @@ bool cForest::ParseForest(char * str)
 		m_Forest.Append(inst);
 		token = strtok(NULL, " ");
 	}
+	Reindex();
 
 	m_Data.TargetCount(m_Targets);
 
-	m_Estimates = new double[m_Records * m_Targets];
-
 	return true;
 }
 
@@ -104,50 +159,128 @@ void cForest::Print(void) const
 	cout << "\n";
 }
 
-cIndividual * cForest::Clone(void)
+void cForest::PrintSimplified(void)
 {
-	cForest * clone = new cForest(m_Data, m_Model, m_FitnessType);
-	clone->m_Beta = m_Beta;
-	clone->m_LeftOutIdx = m_LeftOutIdx;
+	cEFRModel & model = (cEFRModel &) m_Model;
+	unsigned int rule_start = 0;
 
-	clone->m_Forest = m_Forest;
-	clone->m_Fitness = m_Fitness;
-	clone->m_P1 = m_P1;
-	clone->m_P2 = m_P2;
+	for (unsigned int i = 0; i < m_Forest.Count(); i++)
+	{
+		if (m_Forest[i].type == SEPARATOR_INSTRUCTION)
+		{
+			model.PrintSimplified(m_Forest.GetArray(rule_start), i - rule_start);
+			rule_start = i + 1;
+			cout << "; ";
+		}
+	}
+	cout << "\n";
+}
 
-	// memcpy
-	memcpy(clone->m_Estimates, m_Estimates, sizeof(double) * (m_Records * m_Targets));
+bool cForest::Export(const char * fname, const char * name, const bool single)
+{
+	cEFRModel & model = (cEFRModel &) m_Model;
 
-	clone->Debug(IsDebugging());
+	unsigned int len = 0;
+	while (len < m_Forest.Count() && m_Forest[len].type != SEPARATOR_INSTRUCTION)
+		len++;
 
-	return clone;
+	return model.Export(m_Forest.GetArray(0), len, fname, name, single);
+}
+
+cForest::cForest(const cForest & parent) :
+		m_Data(parent.m_Data), m_Model(parent.m_Model), m_FitnessType(parent.m_FitnessType), m_Checkpoints(NULL)
+{
+	Assign(parent);
 }
 
-void cForest::PrintEstimates(void)
+void cForest::Assign(const cForest & parent)
 {
-	for (unsigned int i = 0; i < m_Records; i++)
+	m_Beta = parent.m_Beta;
+	m_P1 = parent.m_P1;
+	m_P2 = parent.m_P2;
+	m_Fitness = parent.m_Fitness;
+
+	m_Targets = parent.m_Targets;
+	m_Inputs = parent.m_Inputs;
+	m_Records = parent.m_Records;
+	m_RowLength = parent.m_RowLength;
+	m_LeftOutIdx = parent.m_LeftOutIdx;
+	m_MaxTreeInstructions = parent.m_MaxTreeInstructions;
+	m_FitnessType = parent.m_FitnessType;
+
+	// a reused forest keeps its buffer if the parent fits in
+	m_Forest = parent.m_Forest;
+	m_SubtreeLeft = parent.m_SubtreeLeft;
+	m_RuleEnd = parent.m_RuleEnd;
+
+	// the offspring resumes its first evaluation from the run of its parent
+	if (parent.m_Checkpoints != NULL)
+		parent.m_Checkpoints->Acquire();
+	if (m_Checkpoints != NULL)
+		m_Checkpoints->Release();
+	m_Checkpoints = parent.m_Checkpoints;
+
+	Debug(parent.IsDebugging());
+}
+
+cIndividual * cForest::Clone(void)
+{
+	cForest * clone = NULL;
+
+	#pragma omp critical(forest_pool)
 	{
-		double * targets = m_Data.Targets(i);
-		cout << fixed << setprecision(9);
-		for (unsigned int j = 0; j < m_Targets; j++)
+		if (s_Pool.Count() > 0)
 		{
-			cout << targets[j] << "\t" << m_Estimates[i * m_Targets + j] << "\t";
+			clone = s_Pool[s_Pool.Count() - 1];
+			s_Pool.Left(s_Pool.Count() - 1);
 		}
+	}
+
+	// the pool may hold forests of another dataset or model
+	if (clone != NULL && (&clone->m_Data != &m_Data || &clone->m_Model != &m_Model))
+	{
+		delete clone;
+		clone = NULL;
+	}
+
+	if (clone == NULL)
+		return new cForest(*this);
+
+	clone->Assign(*this);
+	return clone;
+}
 
-		if (i == m_LeftOutIdx)
-			cout << "(LEFT OUT)";
+void cForest::Release(void)
+{
+	// the checkpoints are shared, the other forests may free them before this one is reused
+	if (m_Checkpoints != NULL)
+		m_Checkpoints->Release();
+	m_Checkpoints = NULL;
 
-		cout << endl;
+	#pragma omp critical(forest_pool)
+	s_Pool.Append(this);
+}
+
+void cForest::ClearPool(void)
+{
+	for (unsigned int i = 0; i < s_Pool.Count(); i++)
+	{
+		delete s_Pool[i];
 	}
+	s_Pool.Clear();
 }
 
-void cForest::Evaluate(void)
+void cForest::Evaluate(const unsigned int station, const cFitnessBound * bound)
 {
 	unsigned int rule_start = 0;
 	unsigned int target_idx = 0;
 
-	// do not forget to delete the estimates
-	memset(m_Estimates, 0, sizeof(double) * m_Records * m_Targets);
+	cEFRModel & model = (cEFRModel &) m_Model;
+
+	// the checkpoints describe the run of a single rule on the only station
+	cSimCheckpoints * record = NULL;
+	if (model.Checkpoints() && model.Stations() == 1 && m_Targets == 1)
+		record = new cSimCheckpoints();
 
 	//Print();
 
@@ -155,9 +288,9 @@ void cForest::Evaluate(void)
 	{
 		if (m_Forest[i].type == SEPARATOR_INSTRUCTION)
 		{
-			// cout << "." << rule_start << "; " << &m_Data << "; " << m_Estimates << "; " << &m_Model << " " << flush;
+			// cout << "." << rule_start << "; " << &m_Data << "; " << &m_Model << " " << flush;
 			// cout << m_Forest.Count() << " " << target_idx << "; " << i - rule_start << flush;
-			if (m_Model.Execute(&m_Forest[rule_start], i - rule_start, m_Data, m_Estimates, target_idx))
+			if (model.Execute(&m_Forest[rule_start], i - rule_start, m_Data, NULL, target_idx, station, bound, (record != NULL) ? m_Checkpoints : NULL, record))
 			{
 				// cout << "+" << endl;
 				rule_start = i + 1;
@@ -171,22 +304,36 @@ void cForest::Evaluate(void)
 			}
 		}
 	}
+
+	// runs with the full trace do not record, the previous checkpoints are still good for resuming
+	if (record != NULL)
+	{
+		if (record->Snapshots() > 0)
+		{
+			if (m_Checkpoints != NULL)
+				m_Checkpoints->Release();
+			m_Checkpoints = record;
+		}
+		else
+		{
+			record->Release();
+		}
+	}
 }
 
 void cForest::Surface(void)
 {
 	unsigned int rule_start = 0;
 
-	// do not forget to delete the estimates
-	memset(m_Estimates, 0, sizeof(double) * m_Records * m_Targets);
-
+	// a single evaluation has no past outputs
+	double estimate = 0;
 	double input[2];
 
 	for (unsigned int i = 0; i < m_Forest.Count(); i++)
 	{
 		if (m_Forest[i].type == SEPARATOR_INSTRUCTION)
 		{
-			// cout << "." << rule_start << "; " << &m_Data << "; " << m_Estimates << "; " << &m_Model << " " << flush;
+			// cout << "." << rule_start << "; " << &m_Data << "; " << &m_Model << " " << flush;
 			// cout << m_Forest.Count() << " " << target_idx << "; " << i - rule_start << flush;
 			for (double k = 0; k <= 1.05; k += 0.05)
 			{
@@ -195,7 +342,7 @@ void cForest::Surface(void)
 					input[0] = k;
 					input[1] = l;
 					double res = ((cEFRModel &) m_Model).ExecuteOnce(&m_Forest[rule_start], i - rule_start, input, 2,
-							m_Estimates);
+							&estimate);
 					cout << k << "\t" << l << "\t" << res << endl;
 				}
 			}
@@ -223,49 +370,273 @@ void cForest::Dot(void)
 
 double cForest::ComputeFitness(void)
 {
-	Evaluate();
-	if(m_FitnessType != FIT_FSCORE2)
+	if (FromCache())
+		return m_Fitness;
+
+	SimulateFitness();
+	ToCache();
+
+	return m_Fitness;
+}
+
+// FSCORE2 does not simulate P1 and P2 and the runs with the full trace are made for the trace
+bool cForest::FromCache(void)
+{
+	cEFRModel & model = (cEFRModel &) m_Model;
+	cFitnessCache * cache = model.FitnessCache();
+
+	if (m_FitnessType == FIT_FSCORE2 || model.Solar()->fullTrace())
+		return false;
+
+	bool hit = (cache != NULL) && cache->Lookup(m_Forest.GetArray(0), m_Forest.Count(), &m_P1, &m_P2);
+
+	// the earlier runs on disk come second, their hits go to the cache
+	if (!hit && model.EvalDB() != NULL)
 	{
-		((cEFRModel&) m_Model).m_Solar->calcFitness(&m_P1, &m_P2);
+		cEvalDB::t_Key key;
+		hit = model.EvalKey(m_Forest.GetArray(0), m_Forest.Count(), key) && model.EvalDB()->Lookup(key, &m_P1, &m_P2);
+
+		if (hit && cache != NULL)
+			cache->Store(m_Forest.GetArray(0), m_Forest.Count(), m_P1, m_P2);
+	}
+
+	if (!hit)
+		return false;
+
+	// the size penalty counts the NOOPs, which are not part of the key
+	m_Fitness = FitnessOf(m_P1, m_P2);
+	return true;
+}
+
+void cForest::ToCache(void)
+{
+	cEFRModel & model = (cEFRModel &) m_Model;
+	cFitnessCache * cache = model.FitnessCache();
+
+	if (m_FitnessType == FIT_FSCORE2 || model.Solar()->fullTrace())
+		return;
+
+	if (cache != NULL)
+		cache->Store(m_Forest.GetArray(0), m_Forest.Count(), m_P1, m_P2);
+
+	ToEvalDB(NULL);
+}
+
+bool cForest::FromEvalDB(cSimStats * stats)
+{
+	cEFRModel & model = (cEFRModel &) m_Model;
+	cEvalDB::t_Key key;
+
+	if (model.EvalDB() == NULL || m_FitnessType == FIT_FSCORE2 || !model.EvalKey(m_Forest.GetArray(0), m_Forest.Count(), key))
+		return false;
+
+	if (!model.EvalDB()->Lookup(key, &m_P1, &m_P2, stats))
+		return false;
+
+	m_Fitness = FitnessOf(m_P1, m_P2);
+	return true;
+}
+
+void cForest::ToEvalDB(const cSimStats * stats)
+{
+	cEFRModel & model = (cEFRModel &) m_Model;
+	cEvalDB::t_Key key;
+
+	if (model.EvalDB() == NULL || m_FitnessType == FIT_FSCORE2 || !model.EvalKey(m_Forest.GetArray(0), m_Forest.Count(), key))
+		return;
+
+	model.EvalDB()->Store(key, m_P1, m_P2, stats);
+}
+
+double cForest::SimulateFitness(void)
+{
+	cEFRModel & model = (cEFRModel &) m_Model;
+	const int stations = model.Stations();
+
+	if (stations == 1)
+	{
+		Evaluate();
+		if(m_FitnessType != FIT_FSCORE2)
+		{
+			model.Solar()->calcFitness(&m_P1, &m_P2);
+		}
+	}
+	else
+	{
+		double p1[cEFRModel::MAX_STATIONS], p2[cEFRModel::MAX_STATIONS];
+
+		// simulate the stations concurrently unless we already run in a parallel region,
+		// the first station stays on the calling thread so its simulator holds the stats
+		#pragma omp parallel for schedule(static, 1) if(omp_get_level() == 0)
+		for (int s = 0; s < stations; s++)
+		{
+			Evaluate(s);
+			if(m_FitnessType != FIT_FSCORE2)
+			{
+				model.Solar(s)->calcFitness(&p1[s], &p2[s]);
+			}
+		}
+
+		if(m_FitnessType != FIT_FSCORE2)
+		{
+			model.ReduceStations(p1, p2, &m_P1, &m_P2);
+		}
 	}
 	// cout << m_P1 << "\t" << m_P2 << endl;
 
-	const double P = (1.0 - m_P1);
-	const double R = (1.0 - m_P2);
+	m_Fitness = FitnessOf(m_P1, m_P2);
+
+	// cout << m_Fitness << endl;
+
+	return m_Fitness;
+}
+
+double cForest::FitnessOf(const double p1, const double p2) const
+{
+	double fitness = m_Fitness;
+
+	const double P = (1.0 - p1);
+	const double R = (1.0 - p2);
 
 	// cout << P << "\t" << R << endl;
 
 	if (m_FitnessType == FIT_FSCORE)
 	{
-		m_Fitness = 0;
+		fitness = 0;
 
 		if (P + R != 0)
 		{
 			//use F2 by CJvanRijsbergen
-			m_Fitness = (1 + m_Beta * m_Beta) * P * R / (m_Beta * m_Beta * P + R);
+			fitness = (1 + m_Beta * m_Beta) * P * R / (m_Beta * m_Beta * P + R);
 		}
 	}
 	else if (m_FitnessType == FIT_WAVG)
 	{
-		m_Fitness = 1 - (m_Beta * m_P1 + m_P2) / (m_Beta + 1);
+		fitness = 1 - (m_Beta * p1 + p2) / (m_Beta + 1);
 	}
 	else if (m_FitnessType == FIT_FSCORE2)
 	{
-		m_Fitness = 1 - sqrt(m_P2*20*m_P2*20 + m_P1*m_P1);
-		if(m_Fitness < 0)
+		fitness = 1 - sqrt(p2*20*p2*20 + p1*p1);
+		if(fitness < 0)
 		{
-			m_Fitness = 0.0;
+			fitness = 0.0;
 		}
 	}
 
 	//lets have some penalty if the no. of instructions is too high
 	if (m_Forest.Count() > m_MaxTreeInstructions)
 	{
-		m_Fitness = m_Fitness / ((double) m_Forest.Count() / m_MaxTreeInstructions);
+		fitness = fitness / ((double) m_Forest.Count() / m_MaxTreeInstructions);
 		// cout << "F*" << endl;
 	}
 
-	// cout << m_Fitness << endl;
+	return fitness;
+}
+
+// all fitness types decrease in P1 and P2, so lower bounds of them give an upper bound of the fitness
+class cForestBound : public cFitnessBound
+{
+		const cForest & m_Forest;
+		const double m_Threshold;
+
+	public:
+		cForestBound(const cForest & forest, const double threshold) : m_Forest(forest), m_Threshold(threshold) {};
+
+		virtual bool Unreachable(const double p1, const double p2) const
+		{
+			return m_Forest.FitnessOf(p1, p2) < m_Threshold;
+		}
+};
+
+void cForest::ComputeFitnessBatch(cForest ** forests, const unsigned int count)
+{
+	cForest * lanes[cBatchSim::LANES];
+	unsigned int n = 0;
+
+	// the cached forests are done, the others fill the lanes
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (forests[i]->FromCache())
+			continue;
+
+		lanes[n++] = forests[i];
+		if (n == cBatchSim::LANES)
+		{
+			ComputeLanes(lanes, n);
+			n = 0;
+		}
+	}
+
+	if (n > 0)
+		ComputeLanes(lanes, n);
+}
+
+void cForest::ComputeLanes(cForest ** forests, const unsigned int n)
+{
+	cEFRModel & model = (cEFRModel &) forests[0]->m_Model;
+
+	const t_Instruction * rules[cBatchSim::LANES];
+	unsigned int lens[cBatchSim::LANES];
+	double p1[cBatchSim::LANES], p2[cBatchSim::LANES];
+
+	// the lockstep path covers one station and single-rule forests using the simulated P1 and P2
+	bool batch = (model.Stations() == 1);
+	for (unsigned int i = 0; i < n && batch; i++)
+	{
+		cForest * forest = forests[i];
+		const unsigned int len = forest->NextInstruction(forest->m_Forest.GetArray(0), SEPARATOR_INSTRUCTION);
+
+		rules[i] = forest->m_Forest.GetArray(0);
+		lens[i] = len;
+		batch = (forest->m_FitnessType != FIT_FSCORE2) && (len + 1 == forest->m_Forest.Count());
+	}
+
+	if (batch && model.ExecuteBatch(rules, lens, n, p1, p2))
+	{
+		for (unsigned int i = 0; i < n; i++)
+		{
+			cForest * forest = forests[i];
+			forest->m_P1 = p1[i];
+			forest->m_P2 = p2[i];
+			forest->m_Fitness = forest->FitnessOf(p1[i], p2[i]);
+		}
+	}
+	else
+	{
+		for (unsigned int i = 0; i < n; i++)
+		{
+			forests[i]->SimulateFitness();
+		}
+	}
+
+	for (unsigned int i = 0; i < n; i++)
+	{
+		forests[i]->ToCache();
+	}
+}
+
+double cForest::ComputeFitnessBounded(const double threshold)
+{
+	cEFRModel & model = (cEFRModel &) m_Model;
+
+	// the stations are reduced only at the end and FSCORE2 does not use the simulated P1 and P2
+	if (model.Stations() > 1 || m_FitnessType == FIT_FSCORE2)
+	{
+		return ComputeFitness();
+	}
+
+	if (FromCache())
+		return m_Fitness;
+
+	cForestBound bound(*this, threshold);
+
+	Evaluate(0, &bound);
+	model.Solar()->calcFitness(&m_P1, &m_P2);
+	m_Fitness = FitnessOf(m_P1, m_P2);
+
+	// a stopped run only has lower bounds of P1 and P2
+	if (model.Solar()->simFinished())
+		ToCache();
 
 	return m_Fitness;
 }
@@ -311,12 +682,16 @@ void cForest::Mutate(const unsigned int ignore, const double mut_probability)
 				// insert to right of this instruction (it is reverese polish notation)
 				if (i + 1 < rule_size && m_Forest[i + 1].type == NOOP_INSTRUCTION)
 				{
+					// the new node spans its operand, the other subtrees keep their extent
 					m_Forest[i + 1] = un_op;
+					m_SubtreeLeft[i + 1] = m_SubtreeLeft[i];
 				}
 				else
 				{
 					m_Forest.Insert(i + 1, &un_op);
 					rule_size++;
+					ShiftIndex(i + 1, 0, 1);
+					m_SubtreeLeft[i + 1] = m_SubtreeLeft[i];
 				}
 				// do not mutate this newly inserted node
 				i += 1;
@@ -331,7 +706,7 @@ void cForest::Mutate(const unsigned int ignore, const double mut_probability)
 				{
 					if (arity == 1 && (rule_size > 3 || !m_Model.Nontrivial())) // if unary, delete
 					{
-						current.type = NOOP_INSTRUCTION;
+						current.type = NOOP_INSTRUCTION; // the subtrees keep their extent
 						_dbg << "dN : " << i << " (" << rule_size << ")" << endl;
 					}
 					else // replace by compatible (same arity)
@@ -343,14 +718,17 @@ void cForest::Mutate(const unsigned int ignore, const double mut_probability)
 				}
 				else // replace branch ...
 				{
-					const unsigned int from = SubtreeLeft(i, arity);
+					const unsigned int from = SubtreeLeft(i);
 
 					// this can be optimized if the new tree is bigger than old one - just overwrite and fill with NOOPS
-					cArrayConst<t_Instruction> rand_tree = m_Model.RandomTree(m_Inputs, m_Targets);
+					cArrayConst<t_Instruction> rand_tree(cArena::Local().Alloc<t_Instruction>(m_MaxTreeInstructions), m_MaxTreeInstructions);
+					m_Model.RandomTree(m_Inputs, m_Targets, rand_tree);
 
 					_dbg << "rB : " << from << " " << i << " " << rand_tree.Count() << " (" << rule_size << ")" << endl;
 
 					m_Forest.Replace(from, i, rand_tree.GetArray(0), rand_tree.Count());
+					ShiftIndex(from, i + 1 - from, rand_tree.Count());
+					IndexRange(from, from + rand_tree.Count());
 
 					rule_size = rule_size - (i + 1 - from) + rand_tree.Count();
 					// cout << "   : (" << rule_size << ")" << endl;
@@ -367,11 +745,13 @@ void cForest::Mutate(const unsigned int ignore, const double mut_probability)
 
 void cForest::Crossover(const unsigned int ignore, arg::cIndividual & o, const double cross_probability)
 {
-	cArrayConst<t_Instruction> offspring1;
-	cArrayConst<t_Instruction> offspring2;
-
 	cForest & other = (cForest &) o;
 
+	// an offspring never has more instructions than both parents together
+	const unsigned int size = m_Forest.Count() + other.m_Forest.Count();
+	cArrayConst<t_Instruction> offspring1(cArena::Local().Alloc<t_Instruction>(size), size);
+	cArrayConst<t_Instruction> offspring2(cArena::Local().Alloc<t_Instruction>(size), size);
+
 	unsigned int parent1_i = 0;
 	unsigned int parent2_i = 0;
 
@@ -379,8 +759,9 @@ void cForest::Crossover(const unsigned int ignore, arg::cIndividual & o, const d
 	{
 		if (arg::cStaticRandom::Next(1.0) < cross_probability)
 		{
-			unsigned int p1_j = parent1_i + NextInstruction(m_Forest.GetArray(parent1_i), SEPARATOR_INSTRUCTION);
-			unsigned int p2_j = parent2_i + NextInstruction(other.m_Forest.GetArray(parent2_i), SEPARATOR_INSTRUCTION);
+			// the rules are copied whole, so each parent is at the start of its rule i
+			unsigned int p1_j = RuleEnd(i);
+			unsigned int p2_j = other.RuleEnd(i);
 
 			// unsigned int rand1 = parent1_i;
 			// unsigned int rand2 = parent2_i;
@@ -402,8 +783,8 @@ void cForest::Crossover(const unsigned int ignore, arg::cIndividual & o, const d
 				// dbg << "Arity 1: " << m_Forest[rand1].type / 100 << " (" << m_Forest[rand1].type << ")"  << endl;
 				// dbg << "Arity 2: " << other.m_Forest[rand2].type / 100 << " (" << other.m_Forest[rand2].type << ")"<< endl;
 
-				unsigned int left1 = SubtreeLeft(rand1, m_Forest[rand1].type / 100);
-				unsigned int left2 = other.SubtreeLeft(rand2, other.m_Forest[rand2].type / 100);
+				unsigned int left1 = SubtreeLeft(rand1);
+				unsigned int left2 = other.SubtreeLeft(rand2);
 
 				if (m_Forest[rand1].type == PROCESS_ALL_INSTRUCTION)
 				{
@@ -478,8 +859,13 @@ void cForest::Crossover(const unsigned int ignore, arg::cIndividual & o, const d
 
 	if (!m_Model.Nontrivial() || (offspring1.Count() > 2 && offspring2.Count() > 2))
 	{
+		// the offspring live in the arena, the forests copy them into their own buffers
 		m_Forest = offspring1;
 		other.m_Forest = offspring2;
+
+		// the NOOPs are dropped on the way, the offspring are indexed in one pass each
+		Reindex();
+		other.Reindex();
 	} //otherwise simply skip
 
 	if (IsDebugging())
@@ -513,5 +899,6 @@ void cForest::GetParams(double * params, const unsigned int size)
 
 cForest::~cForest()
 {
-	delete[] m_Estimates;
+	if (m_Checkpoints != NULL)
+		m_Checkpoints->Release();
 }
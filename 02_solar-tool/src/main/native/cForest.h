@@ -17,7 +17,6 @@ class cForest : public arg::cIndividual
 
 	private:
 		cData & m_Data;
-		double * m_Estimates;
 
 		double m_Beta;
 
@@ -38,32 +37,81 @@ class cForest : public arg::cIndividual
 		// a forest of rules, each in reverse polish notation
 		arg::cArrayConst<t_Instruction> m_Forest;
 
-		inline unsigned int SubtreeLeft(const unsigned int right, const unsigned int arity);
+		// subtree index: the first instruction of the subtree ending at each instruction and the
+		// separator of each rule, kept up to date by every change of the forest
+		arg::cArrayConst<unsigned int> m_SubtreeLeft;
+		arg::cArrayConst<unsigned int> m_RuleEnd;
+		arg::cArrayConst<unsigned int> m_Roots; ///< scratch stack of the index build
+
+		// checkpoints of the last fitness only run, shared with the clones (NULL if none)
+		cSimCheckpoints * m_Checkpoints;
+
+		// released forests kept for the next clones, shared by all threads
+		static arg::cArrayConst<cForest*> s_Pool;
+
+		/** A copy of the parent, without drawing a random forest first. */
+		cForest(const cForest & parent);
+		cForest& operator=(const cForest&);
+		/** Take over the forest, fitness and checkpoints of the parent. */
+		void Assign(const cForest & parent);
+
+		/** Build the subtree index in one pass over the forest. */
+		void Reindex(void);
+		/** Index the instructions [from, to), the first of them starts a rule or a tree. */
+		void IndexRange(const unsigned int from, const unsigned int to);
+		/** Move the index entries after a replacement of removed instructions at from by inserted ones. */
+		void ShiftIndex(const unsigned int from, const unsigned int removed, const unsigned int inserted);
+		/** \returns The first instruction of the subtree ending at right. */
+		inline unsigned int SubtreeLeft(const unsigned int right);
+		/** \returns The position of the separator of the rule. */
+		inline unsigned int RuleEnd(const unsigned int rule);
 		inline unsigned int SelectiveCopy(t_Instruction * from, arg::cArrayConst<t_Instruction> & to, const t_InstructionType ignore = NOOP_INSTRUCTION, const t_InstructionType stop = SEPARATOR_INSTRUCTION);
 		inline unsigned int SelectiveCopyN(t_Instruction * from, arg::cArrayConst<t_Instruction> & to, const unsigned int N, const t_InstructionType ignore = NOOP_INSTRUCTION);
 		inline unsigned int NextInstruction(t_Instruction * from, const t_InstructionType target);
 
+		/** Take P1, P2 and the fitness from the cache or the database of the model, \returns False on a miss. */
+		bool FromCache(void);
+		void ToCache(void);
+		double SimulateFitness(void);
+		static void ComputeLanes(cForest ** forests, const unsigned int count);
+
 	public:
 		cForest(cData & data, cModel & model, t_FitnessType = FIT_FSCORE);
 
 		virtual double ComputeFitness(void);
+		virtual double ComputeFitnessBounded(const double threshold);
+		/** Compute the fitness of several forests, in lockstep batches where the model allows it. */
+		static void ComputeFitnessBatch(cForest ** forests, const unsigned int count);
+		/** \returns The fitness given by P1 and P2, including the size penalty. */
+		double FitnessOf(const double p1, const double p2) const;
 		virtual void Mutate(const unsigned int, const double pM);
 		virtual void Crossover(const unsigned int, arg::cIndividual & other, const double pM);
 		virtual void Print(void) const;
+		/** Print the simplified plans the rules are evaluated by. */
+		void PrintSimplified(void);
+		/** Export the rule of the first target as a C function, see cEFRModel::Export. */
+		bool Export(const char * fname, const char * name, const bool single = false);
+		/** \returns A copy of the forest, a released forest is reused if there is one. */
 		virtual arg::cIndividual * Clone(void);
+		/** Keep the forest for the next clones. */
+		virtual void Release(void);
+		/** Delete the forests kept for reuse. */
+		static void ClearPool(void);
 		virtual int Length(void){return m_Forest.Count();};
 
-		void Evaluate(void);
+		void Evaluate(const unsigned int station = 0, const cFitnessBound * bound = NULL);
+
+		/** Take the fitness and the stats of a run with the full trace from the evaluation database. */
+		bool FromEvalDB(cSimStats * stats);
+		/** Keep P1 and P2 and the stats (NULL for a fitness only run) in the evaluation database. */
+		void ToEvalDB(const cSimStats * stats);
 		void Surface(void);
 		void Dot(void);
 		bool ParseForest(char * str);
 
-		void PrintEstimates(void);
 		void Beta(const double val) {m_Beta = val;};
 
 		// For testing only
-		void StealEstimates(void);
-		void RandEstimates(void);
 		void GenenerateTestForest(void);
 
 		void Compact(void);
@@ -82,6 +130,7 @@ class cForest : public arg::cIndividual
 inline void cForest::Compact(void)
 {
 	m_Model.Compact(m_Forest);
+	Reindex();
 }
 
 inline unsigned int cForest::ParamCount(void)
@@ -109,25 +158,14 @@ inline void cForest::SetParams(const double * params, const unsigned int size)
 	}
 }
 
-inline unsigned int cForest::SubtreeLeft(const unsigned int right, const unsigned int arity)
+inline unsigned int cForest::SubtreeLeft(const unsigned int right)
 {
-	// this will work without tests for well-formed trees
-	// we will replace [from, i] in the original tree
-	unsigned int required = arity;
-	unsigned int from = right;
-
-	while (required > 0)
-	{
-		from--;
-		unsigned int curr_arity = m_Forest[from].type / 100;
+	return m_SubtreeLeft[right];
+}
 
-		if (m_Forest[from].type != NOOP_INSTRUCTION)
-		{
-			required--;
-			required += curr_arity;
-		}
-	}
-	return from;
+inline unsigned int cForest::RuleEnd(const unsigned int rule)
+{
+	return m_RuleEnd[rule];
 }
 
 inline unsigned int cForest::SelectiveCopy(t_Instruction * from, arg::cArrayConst<t_Instruction> & to, const t_InstructionType ignore, const t_InstructionType stop)
@@ -1,22 +1,31 @@
 #include "cGenProg.h"
+#include "cArena.h"
 
-cGenProg::cGenProg(cForest::t_FitnessType fit_type, const unsigned int pop_size, cData & data, cModel & model, const bool debug) : m_Model(model), m_Data(data)
+#include <omp.h>
+
+cGenProg::cGenProg(cForest::t_FitnessType fit_type, const unsigned int pop_size, cData & data, cModel & model, const bool debug, const bool batch) : m_Model(model), m_Data(data)
 {
 	m_FitnessType = fit_type;
+	m_Batch = batch;
 	Debug(debug);
 
 	m_Population.Clear();
 
+	// the random trees are generated serially to keep the population seed-deterministic
 	for (unsigned int i = 0; i < pop_size; i++)
 	{
 		cForest * individual = new cForest(m_Data, m_Model, m_FitnessType);
 		individual->Debug(IsDebugging());
-		individual->ComputeFitness();
 		m_Population.Append(individual);
+	}
+
+	ComputePopulationFitness(0, pop_size);
 
-		if (IsDebugging())
+	if (IsDebugging())
+	{
+		for (unsigned int i = 0; i < pop_size; i++)
 		{
-			individual->Print();
+			m_Population[i]->Print();
 		}
 	}
 	m_SelectionType = 0;
@@ -32,15 +41,87 @@ void cGenProg::Shuffle(void)
 		dbg << "Best and Worst fitness are equal, the population might stagnate. Shuffling.\n";
 		for (unsigned int i = m_Population.Count() / 2; i < m_Population.Count(); i++)
 		{
-			delete m_Population[i];
+			m_Population[i]->Release();
 			m_Population[i] = new cForest(m_Data, m_Model, m_FitnessType);
 			m_Population[i]->Debug(IsDebugging());
-			m_Population[i]->ComputeFitness();
 		}
+		ComputePopulationFitness(m_Population.Count() / 2, m_Population.Count());
 		SortPopulation();
 	}
 }
 
+unsigned int cGenProg::Generation(const double pC, const double pM, const unsigned int lambda, const bool prevent, const bool shuffle)
+{
+	unsigned int evals = 0;
+
+	// the temporaries of the operators of the previous generation are gone
+	cArena::Local().Reset();
+
+	if (m_MigrationType == arg::cGA::GENERATIONAL)
+	{
+		Breed(lambda, pC, pM);
+		ComputeOffspringFitness();
+		Migrate(prevent);
+		evals = lambda;
+	}
+	else
+	{
+		Select();
+		Recombine(pC);
+		Mutate(pM);
+		ComputeChildFitness();
+		Migrate(prevent);
+		evals = 2;
+	}
+
+	if (shuffle)
+		Shuffle();
+
+	return evals;
+}
+
+void cGenProg::ComputePopulationFitness(const unsigned int from, const unsigned int to)
+{
+	ComputeFitness(m_Population.GetArray(from), to - from);
+}
+
+void cGenProg::ComputeOffspringFitness(void)
+{
+	ComputeFitness(m_Offspring.GetArray(0), m_Offspring.Count());
+	dbg << "Offspring fitness computed.\n";
+}
+
+void cGenProg::ComputeFitness(arg::cIndividual ** individuals, const unsigned int count)
+{
+	// individuals are independent, each thread evaluates in its own context,
+	// an island already runs on its own thread and evaluates serially
+	if (!m_Batch)
+	{
+		#pragma omp parallel for schedule(dynamic) if(omp_get_level() == 0)
+		for (int i = 0; i < (int) count; i++)
+		{
+			individuals[i]->ComputeFitness();
+		}
+		return;
+	}
+
+	// one lockstep batch per task
+	const int batches = (count + cBatchSim::LANES - 1) / cBatchSim::LANES;
+
+	#pragma omp parallel for schedule(dynamic) if(omp_get_level() == 0)
+	for (int b = 0; b < batches; b++)
+	{
+		const unsigned int from = b * cBatchSim::LANES;
+		const unsigned int n = (count - from < cBatchSim::LANES) ? count - from : cBatchSim::LANES;
+
+		cForest * forests[cBatchSim::LANES];
+		for (unsigned int i = 0; i < n; i++)
+			forests[i] = (cForest *) individuals[from + i];
+
+		cForest::ComputeFitnessBatch(forests, n);
+	}
+}
+
 cGenProg::~cGenProg()
 {
 }
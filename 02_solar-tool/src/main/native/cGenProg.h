@@ -15,10 +15,20 @@ class cGenProg : public arg::cGA
 
 		cForest::t_FitnessType m_FitnessType;
 
+		bool m_Batch; ///< evaluate groups of individuals in lockstep (cBatchSim)
+
+		void ComputePopulationFitness(const unsigned int from, const unsigned int to);
+		void ComputeFitness(arg::cIndividual ** individuals, const unsigned int count);
+
 	public:
-		cGenProg(cForest::t_FitnessType fit_type, const unsigned int pop_size, cData & data, cModel & model, const bool debug = false);
+		cGenProg(cForest::t_FitnessType fit_type, const unsigned int pop_size, cData & data, cModel & model, const bool debug = false, const bool batch = false);
 
 		virtual void Shuffle(void);
+		virtual void ComputeOffspringFitness(void);
+
+
+		/** Process one generation of the configured GA loop, returns the number of evaluations. */
+		unsigned int Generation(const double pC, const double pM, const unsigned int lambda, const bool prevent, const bool shuffle);
 
 		virtual ~cGenProg();
 };
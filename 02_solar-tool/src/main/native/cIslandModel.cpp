@@ -0,0 +1,126 @@
+#include "cIslandModel.h"
+
+cIslandModel::cIslandModel(cForest::t_FitnessType fit_type, const unsigned int islands, const unsigned int pop_size, cData & data, cModel & model, const unsigned int seed, const bool debug, const bool batch)
+{
+	Debug(debug);
+
+	m_Topology = TOPOLOGY_RING;
+	m_Emigrants = 1;
+
+	for (unsigned int i = 0; i < islands; i++)
+	{
+		const unsigned int island_seed = ((seed > 0) ? seed : THREADSAFE_SEED) + i;
+
+		arg::cRandom * generator = arg::cRandom::GetInstance(arg::cRandom::RNG_MERSENNE_TWISTER);
+		generator->Seed(&island_seed, 1);
+
+		m_Generators.Append(generator);
+		m_Islands.Append(NULL);
+	}
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < (int) islands; i++)
+	{
+		arg::cRandom * previous = arg::cStaticRandom::SwapStaticGenerator(m_Generators[i]);
+		m_Islands[i] = new cGenProg(fit_type, pop_size, data, model, debug, batch);
+		arg::cStaticRandom::SwapStaticGenerator(previous);
+	}
+}
+
+void cIslandModel::SelectionType(const unsigned int val)
+{
+	for (unsigned int i = 0; i < m_Islands.Count(); i++)
+	{
+		m_Islands[i]->SelectionType(val);
+	}
+}
+
+void cIslandModel::MigrationType(const unsigned int val)
+{
+	for (unsigned int i = 0; i < m_Islands.Count(); i++)
+	{
+		m_Islands[i]->MigrationType(val);
+	}
+}
+
+unsigned int cIslandModel::Evolve(const unsigned int generations, const double pC, const double pM, const unsigned int lambda, const bool prevent, const bool shuffle)
+{
+	unsigned int evals = 0;
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:evals)
+	for (int i = 0; i < (int) m_Islands.Count(); i++)
+	{
+		arg::cRandom * previous = arg::cStaticRandom::SwapStaticGenerator(m_Generators[i]);
+
+		for (unsigned int g = 0; g < generations; g++)
+		{
+			evals += m_Islands[i]->Generation(pC, pM, lambda, prevent, shuffle);
+		}
+
+		arg::cStaticRandom::SwapStaticGenerator(previous);
+	}
+
+	return evals;
+}
+
+void cIslandModel::Migrate(void)
+{
+	const unsigned int islands = m_Islands.Count();
+
+	// first pick the emigrants of all islands, so that nobody travels twice in one epoch
+	arg::cArrayConst<arg::cIndividual*> emigrants;
+
+	for (unsigned int i = 0; i < islands; i++)
+	{
+		for (unsigned int k = 0; k < m_Emigrants; k++)
+		{
+			emigrants.Append(m_Islands[i]->IndividualPtr(k)->Clone());
+		}
+	}
+
+	for (unsigned int i = 0; i < islands; i++)
+	{
+		for (unsigned int k = 0; k < m_Emigrants; k++)
+		{
+			arg::cIndividual * emigrant = emigrants[i * m_Emigrants + k];
+
+			if (m_Topology == TOPOLOGY_RING)
+			{
+				m_Islands[(i + 1) % islands]->Immigrate(emigrant);
+			}
+			else
+			{
+				for (unsigned int j = 0; j < islands; j++)
+				{
+					if (j != i)
+						m_Islands[j]->Immigrate(emigrant->Clone());
+				}
+				emigrant->Release();
+			}
+		}
+	}
+	dbg << "Migrated " << m_Emigrants << " individuals from each of " << islands << " islands.\n";
+}
+
+cForest * cIslandModel::WinnerPtr(void) const
+{
+	cForest * winner = (cForest *) m_Islands[0]->WinnerPtr();
+	const bool minimize = m_Islands[0]->IsMinimizing();
+
+	for (unsigned int i = 1; i < m_Islands.Count(); i++)
+	{
+		cForest * candidate = (cForest *) m_Islands[i]->WinnerPtr();
+		if (minimize ? candidate->Fitness() < winner->Fitness() : candidate->Fitness() > winner->Fitness())
+			winner = candidate;
+	}
+	return winner;
+}
+
+cIslandModel::~cIslandModel()
+{
+	for (unsigned int i = 0; i < m_Islands.Count(); i++)
+	{
+		delete m_Islands[i];
+		delete m_Generators[i];
+	}
+}
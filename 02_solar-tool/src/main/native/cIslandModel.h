@@ -0,0 +1,58 @@
+/**
+ * \class cIslandModel
+ * \brief Several cGenProg populations (islands) evolving in parallel.
+ *
+ * Each island evolves independently on its own thread and carries its own random
+ * stream, so the result depends on the seed and the number of islands but not on
+ * the number of threads. Every epoch the best individuals of each island emigrate
+ * to the neighbouring islands (ring) or to all other islands (fully connected).
+ */
+
+#ifndef CISLANDMODEL_H_
+#define CISLANDMODEL_H_
+
+#include "cGenProg.h"
+
+#include <arg/core/cArray.h>
+#include <arg/core/cDebuggable.h>
+#include <arg/utils/cRandom.h>
+
+class cIslandModel : public arg::cDebuggable
+{
+	public:
+		typedef enum {
+			TOPOLOGY_RING = 0,
+			TOPOLOGY_FULL,
+		} t_Topology;
+
+	private:
+		arg::cArrayConst<cGenProg*> m_Islands;
+		arg::cArrayConst<arg::cRandom*> m_Generators; ///< Random stream of each island
+
+		t_Topology m_Topology;
+		unsigned int m_Emigrants;
+
+	public:
+		cIslandModel(cForest::t_FitnessType fit_type, const unsigned int islands, const unsigned int pop_size, cData & data, cModel & model, const unsigned int seed = 0, const bool debug = false, const bool batch = false);
+
+		void SelectionType(const unsigned int val);
+		void MigrationType(const unsigned int val);
+
+		void Topology(const t_Topology val) {m_Topology = val;};
+		void Emigrants(const unsigned int val) {m_Emigrants = val;};
+
+		/** Evolve all islands for a number of generations, returns the number of evaluations. */
+		unsigned int Evolve(const unsigned int generations, const double pC, const double pM, const unsigned int lambda, const bool prevent, const bool shuffle);
+
+		/** Exchange the best individuals between the islands. */
+		void Migrate(void);
+
+		/** \returns Pointer to the best individual of all islands. */
+		cForest * WinnerPtr(void) const;
+
+		unsigned int Islands(void) const {return m_Islands.Count();};
+
+		virtual ~cIslandModel();
+};
+
+#endif /* CISLANDMODEL_H_ */
@@ -11,6 +11,7 @@
 {																			}
 {																			}
 {    UPDATE HISTORY:														}
+{    - small default capacity, Reserve and checked Push					}
 {																			}
 {																			}
 {***************************************************************************/
@@ -21,14 +22,17 @@
 #define __CSTACK_H__
 
 #include <stdio.h>
+#include <stdexcept>
 
 template <class T>
 class cStack
 {
 public:
-	cStack(const unsigned int Size = 1024*1024);
-	cStack(T* Stack, unsigned int Size = 1024*1024);
+	// programs know their stack depth (cModel::StackDepth), size the stack by it
+	cStack(const unsigned int Size = 64);
+	cStack(T* Stack, unsigned int Size);
 	~cStack(void);
+	void Reserve(const unsigned int Size);
 	inline void Push(const T Item);
 	inline T Pop(void);
 	inline T Top(void);
@@ -70,9 +74,30 @@ cStack<T>::~cStack(void)
 	}
 }
 
+template <class T>
+void cStack<T>::Reserve(const unsigned int Size)
+{
+	if (Size <= m_Size)
+		return;
+
+	if (m_Static)
+		throw std::length_error("cStack: cannot grow a stack over external memory");
+
+	T* items = new T[Size];
+	for (int i = 0; i <= m_Sp; i++)
+		items[i] = m_Items[i];
+
+	delete[] m_Items;
+	m_Items = items;
+	m_Size = Size;
+}
+
 template <class T>
 inline void cStack<T>::Push(const T Item)
 {
+	if ((unsigned int)(m_Sp + 1) >= m_Size)
+		throw std::overflow_error("cStack: overflow, the stack was not sized for the program");
+
 	m_Items[++m_Sp] = Item;
 }
 
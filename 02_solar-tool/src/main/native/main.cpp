@@ -10,6 +10,7 @@
 #include "cForest.h"
 #include "cData.h"
 #include "cGenProg.h"
+#include "cIslandModel.h"
 
 #include "model/efr/cEFRModel.h"
 
@@ -44,7 +45,9 @@ void usage_mine(arg::cCLParser & cl)
     cout << "\t" << cl.Program() << " -file <filename> [options]" << endl;
     cout << "\nOptions:\n";
 
-    cout << "\t-file\t\tstring\t file with simulation data.\n";
+    cout << "\t-file\t\tstring\t file with simulation data, comma separated list for several stations.\n";
+    cout << "\t-reduce\t\tint\t station fitness reducer: 0 - mean, 1 - worst case, 2 - weighted (0)\n";
+    cout << "\t-weights\tstring\t comma separated station weights for the weighted reducer (1,...)\n";
     cout << "\t-fit\t\tinteger\t fitness. 0 - fscore; 1 - w arithm mean. Default is 0.\n";
     cout << "\t-maxinst\tinteger\t max. no of instructions in the tree. Default is 200.\n";
     cout << "\t-vv\tbool\t display fitness details.\n\n";
@@ -57,9 +60,27 @@ void usage_mine(arg::cCLParser & cl)
     cout << "\t-sel\t\tint\t selection type (2)\n";
     cout << "\t\t\t\t selection types: 0 - roulette, 1 - elitary, 2 - semielitary\n";
     cout << "\t-mig\t\tint\t migration type (301)\n";
-    cout << "\t\t\t\t migration types: 301 - steady state, 302 - steady state with reverse fitness\n";
+    cout << "\t\t\t\t migration types: 301 - steady state, 302 - steady state with reverse fitness,\n";
+    cout << "\t\t\t\t 303 - generational (mu, lambda) with parallel offspring evaluation\n";
+    cout << "\t-lambda\t\tint\t offspring per generation in generational mode (pop)\n";
+    cout << "\t-islands\tint\t number of islands evolved in parallel (1)\n";
+    cout << "\t-epoch\t\tint\t generations between island migrations (50)\n";
+    cout << "\t-topology\tint\t island topology: 0 - ring, 1 - fully connected (0)\n";
+    cout << "\t-emigrants\tint\t best individuals sent from each island (1)\n";
     cout << "\t-shuffle\t\t shuffle candidates to prevent stagnation (false)\n";
     cout << "\t-prevent\t\t prevent duplicate candidates to prevent stagnation (false)\n";
+    cout << "\t-batch\t\t\t evaluate populations and offspring in lockstep batches (false)\n";
+    cout << "\t-bench\t\tint\t compare scalar and batch evaluation of given number of random rules\n";
+    cout << "\t-checkpoint\t\t resume the offspring simulation from the checkpoints of its parent (false)\n";
+    cout << "\t-cache\t\tint\t memoize the fitness of up to given number of distinct forests (0)\n";
+    cout << "\t-evaldb\t\tstring\t keep the evaluations in a database file shared by the runs (none)\n";
+    cout << "\t-evaldbsize\tint\t records of a newly created evaluation database (262144)\n";
+    cout << "\t-simplify\t\t print the simplified plan of the winner or the query (false)\n";
+    cout << "\t-simplify-eval\t\t simplify the plans of all evaluations (false)\n";
+    cout << "\t-native\t\tstring\t compile the rules of the full trace runs to native code in given directory (none)\n";
+    cout << "\t-export\t\tstring\t export the winner or the query as a C function with a replay harness to given file (none)\n";
+    cout << "\t-export-name\tstring\t name of the exported function (efr_controller)\n";
+    cout << "\t-export-float\t\t export in single precision (false)\n";
     cout << "\t-term-feedback\tint\t for time series; defines the past level of terms (0)\n";
     cout << "\t-out-feedback\tint\t for time series; defines the past level of output node (0)\n";
 
@@ -73,12 +94,182 @@ void usage_mine(arg::cCLParser & cl)
     cout << "\n\n";
 }
 
+// this will be VERY SLOW, the winner is simulated once more to collect the statistics
+void print_run_stats(cForest * winner, cSolarMdlSim * sim)
+{
+    cSimStats run_stats;
+
+    sim->fullTrace(true);
+    winner->Evaluate();
+    sim->fullTrace(false);
+    sim->calcStats(&run_stats);
+    cout << "\t|\t";
+    cout << run_stats.FailD << "\t";
+    cout << run_stats.FailT << "\t";
+    cout << run_stats.FailM << "\t";
+    cout << run_stats.TransOk << "\t";
+    cout << run_stats.MeasOk << "\t";
+    cout << run_stats.OvchCnt << "\t";
+    cout << run_stats.E_Unused << "\t";
+    cout << run_stats.BuffLost << "\t";
+    cout << run_stats.BuffSizeAvg;
+}
+
+// evaluations of children that could not enter the population and were stopped early
+void print_abort_stats(cEFRModel & model, const unsigned int evals)
+{
+    cout << "Aborted\t" << model.AbortedRuns() << " of " << evals << " evaluations, ";
+    cout << model.SavedRows() << " rows saved" << endl;
+
+    if (model.Checkpoints())
+    {
+        cout << "Resumed\t" << model.ResumedRuns() << " of " << evals << " evaluations, ";
+        cout << model.SkippedRows() << " rows skipped" << endl;
+    }
+
+    if (model.FitnessCache() != NULL)
+    {
+        cout << "Cached\t" << model.FitnessCache()->Hits() << " of " << model.FitnessCache()->Lookups() << " lookups" << endl;
+    }
+
+    if (model.EvalDB() != NULL)
+    {
+        cout << "EvalDB\t" << model.EvalDB()->Hits() << " of " << model.EvalDB()->Lookups() << " lookups" << endl;
+    }
+
+    if (model.NativeRules() != NULL)
+    {
+        cout << "Native\t" << model.NativeRules()->Loaded() << " rules loaded, " << model.NativeRules()->Compiled() << " compiled, ";
+        cout << model.NativeRules()->Failed() << " failed" << endl;
+    }
+}
+
+// cache hits of all fitness lookups so far, in the progress line
+void print_cache_stats(cModel & model)
+{
+    cFitnessCache * cache = ((cEFRModel &) model).FitnessCache();
+    if (cache != NULL)
+    {
+        cout << "\t" << cache->Hits() << "/" << cache->Lookups();
+    }
+}
+
+void print_header(arg::cCLParser & cl)
+{
+    cout << "\t\t\tgen\teval\ttime[ms]\tfitness\t\tP1\t\tP2";
+    if (cl.Integer("cache", 0) > 0)
+    {
+        cout << "\t\thits/lookups";
+    }
+    if (cl.Boolean("vv"))
+    {
+        cout << "\t\t|\tFailD \tFailT \tFailM \tTrnsOk \tMeasOk \tOvchCnt\tE_Unused \tBuffLst\tBuffSizeAvg";
+    }
+    cout << endl;
+    cout << "--------------------------------------------------------------------------------------------------";
+
+    if (cl.Boolean("vv"))
+    {
+        cout << "----------------------------------------------------------------------------------------------";
+    }
+
+    cout << endl;
+}
+
+arg::cIndividual * island_alg(arg::cCLParser & cl, cData& data, cModel& model, cSolarMdlSim * sim)
+{
+    int pop_size = cl.Integer("pop", 100);
+    int sel = cl.Integer("sel", arg::cGA::SELECT_SEMIELITARY);
+    int mig = cl.Integer("mig", arg::cGA::STEADY_STATE);
+    int limit = cl.Integer("gen", 1000);
+    int lambda = cl.Integer("lambda", pop_size);
+    int islands = cl.Integer("islands", 1);
+    int epoch = cl.Integer("epoch", 50);
+
+    double pC = cl.Double("c", 0.8);
+    double pM = cl.Double("m", 0.02);
+
+    const bool debug = cl.Boolean("d");
+    const bool prevent = cl.Boolean("prevent");
+    const bool shuffle = cl.Boolean("shuffle");
+
+    cForest::t_FitnessType fit_type = (cForest::t_FitnessType) cl.Integer("fit", cForest::t_FitnessType::FIT_FSCORE);
+
+    cout << "Initializing " << islands << " islands." << endl;
+    cIslandModel im(fit_type, islands, pop_size, data, model, cl.Integer("seed", 0), debug, cl.Boolean("batch"));
+
+    im.SelectionType(sel);
+    im.MigrationType(mig);
+    im.Topology((cIslandModel::t_Topology) cl.Integer("topology", cIslandModel::TOPOLOGY_RING));
+    im.Emigrants(cl.Integer("emigrants", 1));
+
+    cout << "Island model initialized." << endl << endl;
+
+    arg::cTimer timer;
+    timer.CpuStart();
+    unsigned int evals = pop_size * islands;
+
+    print_header(cl);
+    cout << std::fixed << std::setprecision(6);
+
+    double best_fit = 0;
+    int i = 0;
+
+    while (i < limit)
+    {
+        const int generations = (limit - i < epoch) ? limit - i : epoch;
+
+        evals += im.Evolve(generations, pC, pM, lambda, prevent, shuffle);
+        i += generations;
+        im.Migrate();
+
+        cForest * winner = im.WinnerPtr();
+
+        if (winner->Fitness() > best_fit || (i % 100) < generations)
+        {
+            best_fit = std::max(best_fit, winner->Fitness());
+
+            cout << "[" << &im << "]\t" << i << "\t" << evals << "\t" << timer.CpuStop().CpuMillis() << "\t";
+            cout << winner->Fitness() << "\t" << winner->P1() << "\t" << winner->P2();
+            print_cache_stats(model);
+
+            if (cl.Boolean("vv"))
+            {
+                print_run_stats(winner, sim);
+            }
+            cout << endl;
+        }
+    }
+
+    cForest * winner = im.WinnerPtr();
+    cout << std::fixed << "[" << &im << "]\t" << i << "\t" << evals << "\t" << timer.CpuStop().CpuMillis() << "\t";
+    cout << winner->Fitness() << "\t" << winner->P1() << "\t" << winner->P2();
+    print_cache_stats(model);
+    if (cl.Boolean("vv"))
+    {
+        print_run_stats(winner, sim);
+    }
+    cout << endl;
+
+    cout << "Fitness\t" << winner->Fitness() << endl;
+    cout << "Evals/s\t" << evals / timer.CpuStop().CpuSeconds() << endl;
+    print_abort_stats((cEFRModel &) model, evals);
+    cout << endl;
+    return winner->Clone();
+}
+
 arg::cIndividual * gen_alg(arg::cCLParser & cl, cData& data, cModel& model, cSolarMdlSim * sim)
 {
+    if (cl.Integer("islands", 1) > 1)
+    {
+        return island_alg(cl, data, model, sim);
+    }
+
     int pop_size = cl.Integer("pop", 100);
     int sel = cl.Integer("sel", arg::cGA::SELECT_SEMIELITARY);
     int mig = cl.Integer("mig", arg::cGA::STEADY_STATE);
     int limit = cl.Integer("gen", 1000);
+    int lambda = cl.Integer("lambda", pop_size);
 
     double pC = cl.Double("c", 0.8);
     double pM = cl.Double("m", 0.02);
@@ -88,7 +279,7 @@ arg::cIndividual * gen_alg(arg::cCLParser & cl, cData& data, cModel& model, cSol
     cForest::t_FitnessType fit_type = (cForest::t_FitnessType) cl.Integer("fit", cForest::t_FitnessType::FIT_FSCORE);
 
     cout << "Initializing GA." << endl;
-    cGenProg ga(fit_type, pop_size, data, model, debug);
+    cGenProg ga(fit_type, pop_size, data, model, debug, cl.Boolean("batch"));
 
     ga.SelectionType(sel);
     ga.MigrationType(mig);
@@ -102,20 +293,7 @@ arg::cIndividual * gen_alg(arg::cCLParser & cl, cData& data, cModel& model, cSol
     timer.CpuStart();
     unsigned int evals = pop_size;
 
-    cout << "\t\t\tgen\teval\ttime[ms]\tfitness\t\tP1\t\tP2";
-    if (cl.Boolean("vv"))
-    {
-        cout << "\t\t|\tFailD \tFailT \tFailM \tTrnsOk \tMeasOk \tOvchCnt\tE_Unused \tBuffLst\tBuffSizeAvg";
-    }
-    cout << endl;
-    cout << "--------------------------------------------------------------------------------------------------";
-    
-    if (cl.Boolean("vv"))
-    {
-        cout << "----------------------------------------------------------------------------------------------";
-    }
-    
-    cout << endl;
+    print_header(cl);
 
     double winner_fit = 0;
 
@@ -123,21 +301,11 @@ arg::cIndividual * gen_alg(arg::cCLParser & cl, cData& data, cModel& model, cSol
 
     cout << std::fixed << std::setprecision(6);
 
-    cSimStats run_stats;
-
     double best_fit = 0;
 
     for (i = 0; i < limit; i++)
     {
-        ga.Select();
-        ga.Recombine(pC);
-        ga.Mutate(pM);
-        ga.ComputeChildFitness();
-        ga.Migrate(prevent);
-        evals += 2;
-
-        if (cl.Boolean("shuffle"))
-            ga.Shuffle();
+        evals += ga.Generation(pC, pM, lambda, prevent, cl.Boolean("shuffle"));
 
         winner = (cForest*) ga.WinnerPtr();
         winner_fit = winner->Fitness();
@@ -150,22 +318,12 @@ arg::cIndividual * gen_alg(arg::cCLParser & cl, cData& data, cModel& model, cSol
                  << "\t";
                 
             cout << winner_fit << "\t" << winner->P1() << "\t" << winner->P2();
+            print_cache_stats(model);
 
             // this will be VERY SLOW
             if (cl.Boolean("vv"))
             {
-                winner->Evaluate();
-                sim->calcStats(&run_stats);
-                cout << "\t|\t";
-                cout << run_stats.FailD << "\t";
-                cout << run_stats.FailT << "\t";
-                cout << run_stats.FailM << "\t";
-                cout << run_stats.TransOk << "\t";
-                cout << run_stats.MeasOk << "\t";
-                cout << run_stats.OvchCnt << "\t";
-                cout << run_stats.E_Unused << "\t";
-                cout << run_stats.BuffLost << "\t";
-                cout << run_stats.BuffSizeAvg;
+                print_run_stats(winner, sim);
             }
             cout << endl;
         }
@@ -175,22 +333,12 @@ arg::cIndividual * gen_alg(arg::cCLParser & cl, cData& data, cModel& model, cSol
                     << "\t";
             // ga.PrintPopulationInfo();
             cout << winner_fit << "\t" << winner->P1() << "\t" << winner->P2();
+            print_cache_stats(model);
 
             // this will be VERY SLOW
             if (cl.Boolean("vv"))
             {
-                winner->Evaluate();
-                sim->calcStats(&run_stats);
-                cout << "\t|\t";
-                cout << run_stats.FailD << "\t";
-                cout << run_stats.FailT << "\t";
-                cout << run_stats.FailM << "\t";
-                cout << run_stats.TransOk << "\t";
-                cout << run_stats.MeasOk << "\t";
-                cout << run_stats.OvchCnt << "\t";
-                cout << run_stats.E_Unused << "\t";
-                cout << run_stats.BuffLost << "\t";
-                cout << run_stats.BuffSizeAvg;
+                print_run_stats(winner, sim);
             }
             cout << endl;
         }
@@ -199,28 +347,93 @@ arg::cIndividual * gen_alg(arg::cCLParser & cl, cData& data, cModel& model, cSol
     winner = (cForest*) ga.WinnerPtr();
     cout << std::fixed << "[" << &ga << "]\t" << i << "\t" << evals << "\t" << timer.CpuStop().CpuMillis() << "\t";
     cout << winner->Fitness() << "\t" << winner->P1() << "\t" << winner->P2();
+    print_cache_stats(model);
     if (cl.Boolean("vv"))
     {
-        winner->Evaluate();
-        sim->calcStats(&run_stats);
-        cout << "\t|\t";
-        cout << run_stats.FailD << "\t";
-        cout << run_stats.FailT << "\t";
-        cout << run_stats.FailM << "\t";
-        cout << run_stats.TransOk << "\t";
-        cout << run_stats.MeasOk << "\t";
-        cout << run_stats.OvchCnt << "\t";
-        cout << run_stats.E_Unused << "\t";
-        cout << run_stats.BuffLost << "\t";
-        cout << run_stats.BuffSizeAvg;
+        print_run_stats(winner, sim);
     }
     cout << endl;
 
     cout << "Fitness\t" << ga.WinnerPtr()->Fitness() << endl;
+    cout << "Evals/s\t" << evals / timer.CpuStop().CpuSeconds() << endl;
+    print_abort_stats((cEFRModel &) model, evals);
     cout << endl;
     return ga.WinnerPtr()->Clone();
 }
 
+// the first file is the primary station, the others are evaluated alongside
+bool add_stations(arg::cCLParser & cl, cEFRModel & model, cSolarMdlSim * sim, arg::svector & files)
+{
+    std::vector<double> weights = cl.NumericalList("weights", ',');
+
+    model.SolarModel(sim); // cEFRModel deletes the object
+    model.StationReducer((cEFRModel::t_StationReducer) cl.Integer("reduce", cEFRModel::REDUCE_MEAN));
+
+    for (unsigned int i = 0; i < files.size(); i++)
+    {
+        if (i > 0)
+        {
+            cSolarMdlSim * station = new cSolarMdlSim();
+            if (!station->loadDataFile(files[i].c_str()))
+            {
+                cerr << "Could not load station file \'" << files[i] << "\'.\n";
+                delete station;
+                return false;
+            }
+            cout << "#\tLoaded station file \'" << files[i] << "\' with " << station->getDataLength() << " rows\n";
+            model.AddStation(station);
+        }
+
+        if (i < weights.size())
+        {
+            model.StationWeight(i, weights[i]);
+        }
+    }
+    return true;
+}
+
+// throughput of the scalar and the lockstep batch evaluation on the same random rules (one thread)
+void bench_batch(arg::cCLParser & cl, cData & data, cEFRModel & model)
+{
+    const int count = cl.Integer("bench", 64);
+    cForest::t_FitnessType fit_type = (cForest::t_FitnessType) cl.Integer("fit", cForest::t_FitnessType::FIT_FSCORE);
+
+    arg::cArrayConst<cForest*> forests;
+    for (int i = 0; i < count; i++)
+    {
+        forests.Append(new cForest(data, model, fit_type));
+    }
+
+    arg::cArrayConst<double> p1, p2;
+    arg::cTimer timer;
+
+    timer.CpuStart();
+    for (int i = 0; i < count; i++)
+    {
+        forests[i]->ComputeFitness();
+        p1.Append(forests[i]->P1());
+        p2.Append(forests[i]->P2());
+    }
+    const double scalar_time = timer.CpuStop().CpuSeconds();
+
+    timer.CpuStart();
+    cForest::ComputeFitnessBatch(forests.GetArray(0), count);
+    const double batch_time = timer.CpuStop().CpuSeconds();
+
+    int mismatches = 0;
+    for (int i = 0; i < count; i++)
+    {
+        mismatches += (forests[i]->P1() != p1[i] || forests[i]->P2() != p2[i]);
+        delete forests[i];
+    }
+
+    cout << "Rules\t" << count << "\tlanes\t" << cBatchSim::LANES << endl;
+    cout << "Scalar\t" << count / scalar_time << " evals/s" << endl;
+    cout << "Batch\t" << count / batch_time << " evals/s" << endl;
+    cout << "Speedup\t" << scalar_time / batch_time << endl;
+    cout << "Differences\t" << mismatches << endl;
+}
+
 void mine(arg::cCLParser & cl)
 {
     cSolarMdlSim * sim = new cSolarMdlSim();
@@ -246,16 +459,27 @@ void mine(arg::cCLParser & cl)
         model.Debug(cl.Boolean("d"));
         model.Nontrivial(cl.Boolean("nt"));
         model.MaxTreeInstructions(cl.Integer("maxinst", 200));
+        model.Checkpoints(cl.Boolean("checkpoint"));
+        model.FitnessCache(cl.Integer("cache", 0));
+        model.Simplify(cl.Boolean("simplify-eval"));
+        model.NativeRules(cl.String("native"));
+        if (cl.String("evaldb") != NULL)
+        {
+            model.EvalDB(cl.String("evaldb"), cl.Integer("evaldbsize", cEvalDB::DEFAULT_CAPACITY));
+        }
         model.Beta(beta);
 
-        const char * file = cl.String("file", "<none>");
+        arg::svector files = cl.StringList("file", ',');
+        const char * file = files.empty() ? "<none>" : files[0].c_str();
 
-        if (sim->loadDataFile(file))
+        // add_stations reports the station file it could not load
+        const bool loaded = sim->loadDataFile(file);
+        if (loaded && add_stations(cl, model, sim, files))
         {
             cout << "#\tLoaded simulation file \'" << file << "\'\n";
             cout << "#\tRows:" << sim->getDataLength()  << endl;
-            cData data(sim->getDataLength(), 4);
-            model.SolarModel(sim); // cEFRModel deletes the object
+            model.EvalContexts(threads);
+            cData data(model.Records(), 4);
 
             cout << "#\tPrepared data buffer with " << data.Records() << "x" << data.Inputs() << " records.\n";
             int out_feedback = cl.Integer("of", 0);
@@ -272,9 +496,14 @@ void mine(arg::cCLParser & cl)
             model.PastInputLimit(term_feedback);
 
 
-            if (query == NULL)
+            if (cl.Integer("bench", 0) > 0)
+            {
+                bench_batch(cl, data, model);
+            }
+            else if (query == NULL)
             {
                 cForest * winner = (cForest*) gen_alg(cl, data, model, sim);
+                cForest::ClearPool(); // the GA is over, nothing is cloned any more
 
                 double win_fit = winner->Fitness();
 
@@ -283,6 +512,19 @@ void mine(arg::cCLParser & cl)
                 cout << endl;
                 winner->Print();
                 cout << "-------------- " << endl;
+
+                if (cl.Boolean("simplify"))
+                {
+                    cout << "Simplified " << endl;
+                    winner->PrintSimplified();
+                    cout << "-------------- " << endl;
+                }
+
+                if (cl.String("export") != NULL && winner->Export(cl.String("export"), cl.String("export-name", "efr_controller"), cl.Boolean("export-float")))
+                {
+                    cout << "Exported to " << cl.String("export") << endl;
+                }
+                sim->fullTrace(true); // the stats need the whole trace
                 winner->ComputeFitness();
 
                 if (cl.Boolean("v"))
@@ -292,6 +534,7 @@ void mine(arg::cCLParser & cl)
 
                 cout << std::scientific << "Fitness   : " << win_fit << endl;
                 cSimStats* stats = sim->calcStats();
+                winner->ToEvalDB(stats); // a later query of the winner is for free
                 stats->print();
 
                 if (cl.Boolean("dot"))
@@ -308,10 +551,16 @@ void mine(arg::cCLParser & cl)
             {
                 cForest forest(data, model, fit_type);
                 forest.ParseForest(query);
-                forest.ComputeFitness();
 
-
-                cSimStats* stats = sim->calcStats();
+                // the stats of a query evaluated before come from the database
+                cSimStats* stats = new cSimStats();
+                if (!forest.FromEvalDB(stats))
+                {
+                    sim->fullTrace(true); // the stats need the whole trace
+                    forest.ComputeFitness();
+                    sim->calcStats(stats);
+                    forest.ToEvalDB(stats);
+                }
 
                 if (!cl.Boolean("compact"))
                 {
@@ -322,6 +571,18 @@ void mine(arg::cCLParser & cl)
 					forest.Print();
 					cout << "-------------- " << endl;
 
+					if (cl.Boolean("simplify"))
+					{
+						cout << "Simplified " << endl;
+						forest.PrintSimplified();
+						cout << "-------------- " << endl;
+					}
+
+					if (cl.String("export") != NULL && forest.Export(cl.String("export"), cl.String("export-name", "efr_controller"), cl.Boolean("export-float")))
+					{
+						cout << "Exported to " << cl.String("export") << endl;
+					}
+
 					if (cl.Boolean("dot"))
 					{
 						cout << "Dot " << endl;
@@ -350,7 +611,7 @@ void mine(arg::cCLParser & cl)
                 delete stats;
             }
         }
-        else
+        else if (!loaded)
         {
             cerr << "Could not load input file \'" << file << "\'.\n";
         }
@@ -411,6 +672,7 @@ void test(arg::cCLParser & cl)
                 cout << endl;
                 winner->Print();
                 cout << "-------------- " << endl;
+                sim->fullTrace(true); // the stats need the whole trace
                 winner->ComputeFitness();
 
                 if (cl.Boolean("v"))
@@ -437,6 +699,7 @@ void test(arg::cCLParser & cl)
             {
                 cForest forest(data, model, fit_type);
                 forest.ParseForest(query);
+                sim->fullTrace(true); // the stats need the whole trace
                 forest.ComputeFitness();
                 cSimStats* stats = sim->calcStats();
 
@@ -0,0 +1,262 @@
+#include "cEvalDB.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _MSC_VER
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+static const char EVALDB_MAGIC[8] = {'S', 'O', 'L', 'A', 'R', 'E', 'D', 'B'};
+
+cEvalDB::cEvalDB(void) : m_File(-1), m_Map(NULL), m_MapSize(0), m_Capacity(0), m_Records(NULL)
+{
+	m_Lookups = 0;
+	m_Hits = 0;
+}
+
+#ifndef _MSC_VER
+
+bool cEvalDB::Lock(void)
+{
+	struct flock lock;
+	memset(&lock, 0, sizeof(lock));
+	lock.l_type = F_WRLCK;
+	lock.l_whence = SEEK_SET;
+
+	// the whole file, wait for the other processes
+	while (fcntl(m_File, F_SETLKW, &lock) == -1)
+	{
+		if (errno != EINTR)
+			return false;
+	}
+	return true;
+}
+
+void cEvalDB::Unlock(void)
+{
+	struct flock lock;
+	memset(&lock, 0, sizeof(lock));
+	lock.l_type = F_UNLCK;
+	lock.l_whence = SEEK_SET;
+	fcntl(m_File, F_SETLK, &lock);
+}
+
+bool cEvalDB::Open(const char * fname, const unsigned long long capacity)
+{
+	Close();
+
+	m_File = open(fname, O_RDWR | O_CREAT, 0644);
+	if (m_File == -1)
+		return false;
+
+	// the first process creates the table, the others wait for it
+	if (!Lock())
+	{
+		Close();
+		return false;
+	}
+
+	t_Header header;
+	struct stat info;
+	bool valid = (fstat(m_File, &info) == 0);
+
+	if (valid && info.st_size == 0)
+	{
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, EVALDB_MAGIC, sizeof(header.magic));
+		header.version = VERSION;
+		header.record_size = sizeof(t_Record);
+		header.capacity = (capacity > 0) ? capacity : DEFAULT_CAPACITY;
+
+		// the records are zero (empty) in the sparse file
+		valid = (ftruncate(m_File, sizeof(t_Header) + header.capacity * sizeof(t_Record)) == 0)
+				&& (pwrite(m_File, &header, sizeof(header), 0) == (ssize_t) sizeof(header));
+	}
+	else if (valid)
+	{
+		valid = (pread(m_File, &header, sizeof(header), 0) == (ssize_t) sizeof(header))
+				&& memcmp(header.magic, EVALDB_MAGIC, sizeof(header.magic)) == 0
+				&& header.version == VERSION && header.record_size == sizeof(t_Record)
+				&& (unsigned long long) info.st_size >= sizeof(t_Header) + header.capacity * sizeof(t_Record);
+	}
+
+	Unlock();
+
+	if (!valid)
+	{
+		Close();
+		return false;
+	}
+
+	m_Capacity = header.capacity;
+	m_MapSize = sizeof(t_Header) + m_Capacity * sizeof(t_Record);
+	m_Map = mmap(NULL, m_MapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+
+	if (m_Map == MAP_FAILED)
+	{
+		m_Map = NULL;
+		Close();
+		return false;
+	}
+
+	m_Records = (t_Record *) ((char *) m_Map + sizeof(t_Header));
+	return true;
+}
+
+void cEvalDB::Close(void)
+{
+	if (m_Map != NULL)
+		munmap(m_Map, m_MapSize);
+	if (m_File != -1)
+		close(m_File);
+
+	m_File = -1;
+	m_Map = NULL;
+	m_MapSize = 0;
+	m_Capacity = 0;
+	m_Records = NULL;
+}
+
+#else
+
+bool cEvalDB::Lock(void)
+{
+	return false;
+}
+
+void cEvalDB::Unlock(void)
+{
+}
+
+bool cEvalDB::Open(const char * fname, const unsigned long long capacity)
+{
+	(void) fname;
+	(void) capacity;
+	return false;
+}
+
+void cEvalDB::Close(void)
+{
+}
+
+#endif
+
+unsigned int cEvalDB::State(const t_Record * record)
+{
+	unsigned int state;
+
+	// the other fields of a record are complete once its state is seen
+	#pragma omp atomic read seq_cst
+	state = record->state;
+
+	return state;
+}
+
+bool cEvalDB::SameKey(const t_Key & a, const t_Key & b)
+{
+	return a.forest[0] == b.forest[0] && a.forest[1] == b.forest[1] && a.dataset == b.dataset && a.params == b.params;
+}
+
+cEvalDB::t_Record * cEvalDB::Find(const t_Key & key) const
+{
+	const unsigned long long start = (key.forest[0] ^ key.dataset) % m_Capacity;
+
+	// linear probing, records are never removed, so an empty one ends the sequence
+	for (unsigned int i = 0; i < MAX_PROBES && i < m_Capacity; i++)
+	{
+		t_Record * record = &m_Records[(start + i) % m_Capacity];
+		const unsigned int state = State(record);
+
+		if (state == RECORD_EMPTY || SameKey(record->key, key))
+			return record;
+	}
+	return NULL;
+}
+
+bool cEvalDB::Lookup(const t_Key & key, double * p1, double * p2, cSimStats * stats)
+{
+	if (m_Records == NULL)
+		return false;
+
+	const t_Record * record = Find(key);
+	const unsigned int state = (record != NULL) ? State(record) : (unsigned int) RECORD_EMPTY;
+	const bool hit = (state == RECORD_STATS) || (state == RECORD_FITNESS && stats == NULL);
+
+	#pragma omp atomic
+	m_Lookups++;
+
+	if (!hit)
+		return false;
+
+	*p1 = record->p1;
+	*p2 = record->p2;
+
+	if (stats != NULL)
+	{
+		stats->BuffSizeAvg = record->buff_size_avg;
+		stats->E_Unused = record->e_unused;
+		stats->FailM = record->fail_m;
+		stats->FailT = record->fail_t;
+		stats->FailD = record->fail_d;
+		stats->MeasOk = record->meas_ok;
+		stats->TransOk = record->trans_ok;
+		stats->OvchCnt = record->ovch_cnt;
+		stats->BuffLost = record->buff_lost;
+	}
+
+	#pragma omp atomic
+	m_Hits++;
+
+	return true;
+}
+
+void cEvalDB::Store(const t_Key & key, const double p1, const double p2, const cSimStats * stats)
+{
+	if (m_Records == NULL)
+		return;
+
+	// fcntl locks are per process, the threads of this one queue up here
+	#pragma omp critical(eval_db)
+	{
+		if (Lock())
+		{
+			t_Record * record = Find(key);
+			const unsigned int state = (record != NULL) ? record->state : (unsigned int) RECORD_EMPTY;
+
+			if (record != NULL && (state == RECORD_EMPTY || (state == RECORD_FITNESS && stats != NULL)))
+			{
+				record->key = key;
+				record->p1 = p1;
+				record->p2 = p2;
+
+				if (stats != NULL)
+				{
+					record->buff_size_avg = stats->BuffSizeAvg;
+					record->e_unused = stats->E_Unused;
+					record->fail_m = stats->FailM;
+					record->fail_t = stats->FailT;
+					record->fail_d = stats->FailD;
+					record->meas_ok = stats->MeasOk;
+					record->trans_ok = stats->TransOk;
+					record->ovch_cnt = stats->OvchCnt;
+					record->buff_lost = stats->BuffLost;
+				}
+
+				// publish the filled record to the readers
+				const unsigned int filled = (stats != NULL) ? RECORD_STATS : RECORD_FITNESS;
+				#pragma omp atomic write seq_cst
+				record->state = filled;
+			}
+			Unlock();
+		}
+	}
+}
+
+cEvalDB::~cEvalDB(void)
+{
+	Close();
+}
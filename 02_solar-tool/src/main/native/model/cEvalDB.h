@@ -0,0 +1,115 @@
+/**
+ * \class cEvalDB
+ * \brief Evaluation results kept on disk and shared by all runs on the machine.
+ *
+ * The queries and GA runs of a day re-simulate the same controllers on the same station
+ * files over and over. The database is a file mapped into memory: a fixed-size open
+ * addressing table of results keyed by the canonical forest digest (cFitnessCache::Digest),
+ * the content hash of the datasets and the hash of the simulator parameters (cMdlPars), so a
+ * changed dataset or model never matches an old result. A record holds P1 and P2 and, once
+ * a run with the full trace stored them, the cSimStats.
+ *
+ * Any number of processes may read and append at the same time. Readers do not lock: a
+ * record is filled first and then published by an atomic store of its state. Writers take
+ * an fcntl lock of the file (and a critical section against the threads of their own
+ * process). The table does not grow, when a probe sequence is full the result is not kept.
+ *
+ * Needs POSIX mmap, on other platforms Open fails.
+ */
+
+#ifndef CEVALDB_H_
+#define CEVALDB_H_
+
+#include "solarSim.h"
+
+class cEvalDB
+{
+	public:
+		struct t_Key
+		{
+			unsigned long long forest[2];
+			unsigned long long dataset;
+			unsigned long long params;
+		};
+
+		const static unsigned int DEFAULT_CAPACITY = 1u << 18;
+
+	private:
+		const static unsigned int VERSION = 1;
+		const static unsigned int MAX_PROBES = 64;
+
+		typedef enum {
+			RECORD_EMPTY = 0,
+			RECORD_FITNESS,
+			RECORD_STATS,
+		} t_State;
+
+		struct t_Header
+		{
+			char magic[8];
+			unsigned int version;
+			unsigned int record_size;
+			unsigned long long capacity;
+			unsigned char reserved[40];
+		};
+
+		struct t_Record
+		{
+			unsigned int state; ///< t_State, written last
+			unsigned int reserved;
+			t_Key key;
+			double p1;
+			double p2;
+			double buff_size_avg;
+			double e_unused;
+			unsigned int fail_m;
+			unsigned int fail_t;
+			unsigned int fail_d;
+			unsigned int meas_ok;
+			unsigned int trans_ok;
+			unsigned int ovch_cnt;
+			unsigned int buff_lost;
+			unsigned int padding;
+		};
+
+		int m_File;
+		void * m_Map;
+		unsigned long long m_MapSize;
+		unsigned long long m_Capacity;
+		t_Record * m_Records;
+
+		unsigned long m_Lookups;
+		unsigned long m_Hits;
+
+		/** Exclusive lock of the file against the other processes. */
+		bool Lock(void);
+		void Unlock(void);
+
+		static unsigned int State(const t_Record * record);
+		static bool SameKey(const t_Key & a, const t_Key & b);
+		/** \returns The record of the key or the empty record where it belongs, NULL if the probes are full. */
+		t_Record * Find(const t_Key & key) const;
+
+	public:
+		cEvalDB(void);
+
+		/** Open the database, a missing file is created with the given number of records. */
+		bool Open(const char * fname, const unsigned long long capacity = DEFAULT_CAPACITY);
+		void Close(void);
+		bool IsOpen(void) const {return m_Records != NULL;};
+
+		/**
+		 * \returns True and P1, P2 of the key if they are stored. With stats given, only a record
+		 * with the stats is a hit.
+		 */
+		bool Lookup(const t_Key & key, double * p1, double * p2, cSimStats * stats = NULL);
+		/** Store P1, P2 and the stats (if any) of the key, the stats are added to a known record. */
+		void Store(const t_Key & key, const double p1, const double p2, const cSimStats * stats = NULL);
+
+		unsigned long Lookups(void) const {return m_Lookups;};
+		unsigned long Hits(void) const {return m_Hits;};
+
+		~cEvalDB(void);
+};
+
+#endif /* CEVALDB_H_ */
@@ -0,0 +1,208 @@
+#include "cFitnessCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+cFitnessCache::cFitnessCache(const unsigned int capacity) : m_Capacity(capacity > 0 ? capacity : 1)
+{
+	m_Slots = new t_Slot[m_Capacity];
+	for (unsigned int i = 0; i < m_Capacity; i++)
+		m_Slots[i].used = false;
+
+	m_Lookups = 0;
+	m_Hits = 0;
+}
+
+bool cFitnessCache::Canonical(const t_Instruction * forest, const unsigned int len, arg::cArrayConst<t_Node> & key)
+{
+	// start of the canonical subtree of every operand on the stack
+	arg::cArrayConst<unsigned int> starts;
+
+	key.ClearCount();
+
+	for (unsigned int i = 0; i < len; i++)
+	{
+		const t_Instruction & instruction = forest[i];
+
+		if (instruction.type == NOOP_INSTRUCTION)
+			continue;
+
+		t_Node node;
+		node.type = instruction.type;
+		node.value = 0;
+		node.back = 0;
+		node.weight = 0;
+
+		if (instruction.type == SEPARATOR_INSTRUCTION)
+		{
+			if (starts.Count() != 1)
+				return false;
+			starts.ClearCount();
+			key.Append(node);
+			continue;
+		}
+
+		// only the fields the instruction uses are part of the key
+		node.weight = instruction.weight;
+		if (instruction.type == INPUT_INSTRUCTION)
+			node.value = instruction.value;
+		else if (instruction.type == PAST_INPUT_INSTRUCTION || instruction.type == PAST_OUTPUT_INSTRUCTION)
+		{
+			node.value = instruction.value;
+			node.back = instruction.extra_uint;
+		}
+
+		const unsigned int arity = instruction.type / 100;
+
+		if (arity == 0)
+		{
+			starts.Append(key.Count());
+		}
+		else if (arity == 2)
+		{
+			if (starts.Count() < 2)
+				return false;
+
+			const unsigned int second = starts[starts.Count() - 1];
+			const unsigned int first = starts[starts.Count() - 2];
+			const unsigned int end = key.Count();
+			starts.Left(starts.Count() - 1);
+
+			// all binary operators are commutative, the smaller operand goes first
+			t_Node * nodes = key.GetArray(0);
+			if (Less(&nodes[second], end - second, &nodes[first], second - first))
+				std::rotate(&nodes[first], &nodes[second], &nodes[end]);
+		}
+		else if (starts.Count() < 1)
+		{
+			return false;
+		}
+
+		key.Append(node);
+	}
+	return starts.Count() == 0;
+}
+
+bool cFitnessCache::Less(const t_Node * a, const unsigned int a_len, const t_Node * b, const unsigned int b_len)
+{
+	return std::lexicographical_compare(a, a + a_len, b, b + b_len, [](const t_Node & x, const t_Node & y)
+	{
+		if (x.type != y.type)
+			return x.type < y.type;
+		if (x.value != y.value)
+			return x.value < y.value;
+		if (x.back != y.back)
+			return x.back < y.back;
+		return x.weight < y.weight;
+	});
+}
+
+unsigned long long cFitnessCache::Hash(const arg::cArrayConst<t_Node> & key, const bool mix)
+{
+	// FNV-1a over the fields (the padding of the nodes is not hashed), or a multiply-xorshift mix
+	unsigned long long hash = mix ? 0x9E3779B97F4A7C15ULL : 14695981039346656037ULL;
+
+	for (unsigned int i = 0; i < key.Count(); i++)
+	{
+		const t_Node & node = *key.GetArray(i);
+		unsigned long long words[4];
+
+		words[0] = (unsigned int) node.type;
+		words[1] = node.value;
+		words[2] = node.back;
+		memcpy(&words[3], &node.weight, sizeof(double));
+
+		for (unsigned int w = 0; w < 4; w++)
+		{
+			hash ^= words[w];
+			if (mix)
+			{
+				hash *= 0xBF58476D1CE4E5B9ULL;
+				hash ^= hash >> 31;
+			}
+			else
+				hash *= 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+bool cFitnessCache::Digest(const t_Instruction * forest, const unsigned int len, unsigned long long digest[2])
+{
+	arg::cArrayConst<t_Node> key;
+
+	if (!Canonical(forest, len, key))
+		return false;
+
+	digest[0] = Hash(key);
+	digest[1] = Hash(key, true);
+	return true;
+}
+
+bool cFitnessCache::Equal(const arg::cArrayConst<t_Node> & a, const arg::cArrayConst<t_Node> & b)
+{
+	if (a.Count() != b.Count())
+		return false;
+
+	for (unsigned int i = 0; i < a.Count(); i++)
+	{
+		const t_Node & x = *a.GetArray(i);
+		const t_Node & y = *b.GetArray(i);
+
+		if (x.type != y.type || x.value != y.value || x.back != y.back || x.weight != y.weight)
+			return false;
+	}
+	return true;
+}
+
+bool cFitnessCache::Lookup(const t_Instruction * forest, const unsigned int len, double * p1, double * p2)
+{
+	arg::cArrayConst<t_Node> key;
+	bool hit = false;
+
+	if (!Canonical(forest, len, key))
+		return false;
+
+	const unsigned long long hash = Hash(key);
+
+	#pragma omp critical(fitness_cache)
+	{
+		const t_Slot & slot = m_Slots[hash % m_Capacity];
+
+		m_Lookups++;
+		if (slot.used && slot.hash == hash && Equal(slot.key, key))
+		{
+			*p1 = slot.p1;
+			*p2 = slot.p2;
+			m_Hits++;
+			hit = true;
+		}
+	}
+	return hit;
+}
+
+void cFitnessCache::Store(const t_Instruction * forest, const unsigned int len, const double p1, const double p2)
+{
+	arg::cArrayConst<t_Node> key;
+
+	if (!Canonical(forest, len, key))
+		return;
+
+	const unsigned long long hash = Hash(key);
+
+	#pragma omp critical(fitness_cache)
+	{
+		t_Slot & slot = m_Slots[hash % m_Capacity];
+
+		slot.used = true;
+		slot.hash = hash;
+		slot.key = key;
+		slot.p1 = p1;
+		slot.p2 = p2;
+	}
+}
+
+cFitnessCache::~cFitnessCache(void)
+{
+	delete[] m_Slots;
+}
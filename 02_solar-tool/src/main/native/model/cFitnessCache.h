@@ -0,0 +1,70 @@
+/**
+ * \class cFitnessCache
+ * \brief Memo of the simulated P1 and P2 of the forests evaluated so far.
+ *
+ * Elitist selection clones the same parents every generation and many offspring come out
+ * identical to an individual evaluated before (no crossover, no mutation hit, or a rejected
+ * crossover). The forests are keyed by a canonical form: NOOPs are dropped and the operands
+ * of the commutative and/or/sum/prod are put in a fixed order, which does not change the
+ * result (min, max, a+b-ab and ab give bitwise the same value for swapped operands).
+ *
+ * The cache is a direct-mapped table of given capacity, a newer forest replaces the older
+ * one in its slot. The full key is stored and compared, so a hash collision is just a miss.
+ * It is shared by all threads, the slots are accessed in a critical section.
+ */
+
+#ifndef CFITNESSCACHE_H_
+#define CFITNESSCACHE_H_
+
+#include "cModel.h"
+
+#include <arg/core/cArray.h>
+
+class cFitnessCache
+{
+		struct t_Node
+		{
+			int type;
+			unsigned int value;
+			unsigned int back;
+			double weight;
+		};
+
+		struct t_Slot
+		{
+			bool used;
+			unsigned long long hash;
+			arg::cArrayConst<t_Node> key;
+			double p1;
+			double p2;
+		};
+
+		t_Slot * m_Slots;
+		unsigned int m_Capacity;
+
+		unsigned long m_Lookups;
+		unsigned long m_Hits;
+
+		/** Canonical form of a forest, \returns False if a rule is not a well-formed expression. */
+		static bool Canonical(const t_Instruction * forest, const unsigned int len, arg::cArrayConst<t_Node> & key);
+		static bool Less(const t_Node * a, const unsigned int a_len, const t_Node * b, const unsigned int b_len);
+		static unsigned long long Hash(const arg::cArrayConst<t_Node> & key, const bool mix = false);
+		static bool Equal(const arg::cArrayConst<t_Node> & a, const arg::cArrayConst<t_Node> & b);
+
+	public:
+		cFitnessCache(const unsigned int capacity);
+
+		/** Two independent 64-bit hashes of the canonical form, \returns False for a malformed forest. */
+		static bool Digest(const t_Instruction * forest, const unsigned int len, unsigned long long digest[2]);
+
+		/** \returns True and the stored P1 and P2 if the forest (or an equivalent one) is cached. */
+		bool Lookup(const t_Instruction * forest, const unsigned int len, double * p1, double * p2);
+		void Store(const t_Instruction * forest, const unsigned int len, const double p1, const double p2);
+
+		unsigned long Lookups(void) const {return m_Lookups;};
+		unsigned long Hits(void) const {return m_Hits;};
+
+		~cFitnessCache(void);
+};
+
+#endif /* CFITNESSCACHE_H_ */
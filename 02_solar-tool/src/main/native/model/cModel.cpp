@@ -60,6 +60,14 @@ bool cModel::Execute(const t_Instruction * start, const unsigned int len, cData
 	const unsigned int row_width = data.Inputs() + data.Targets();
 	const unsigned int input_len = data.Inputs();
 
+	const int depth = StackDepth(start, len);
+	if (depth < 0)
+	{
+		err << "Something went wrong. The program does not leave exactly one value on the stack.\n";
+		return false;
+	}
+	m_Stack.Reserve(depth);
+
 	if (IsDebugging())
 	{
 		dbg << "Executing: \n ";
@@ -105,9 +113,39 @@ void cModel::Print(const t_Instruction * start, const unsigned int len)
 	} while (current < len);
 }
 
+int cModel::StackDepth(const t_Instruction * start, const unsigned int len)
+{
+	int depth = 0, max_depth = 0;
+
+	for (unsigned int i = 0; i < len; i++)
+	{
+		if (start[i].type == NOOP_INSTRUCTION)
+			continue;
+		if (start[i].type == SEPARATOR_INSTRUCTION)
+			return -1;
+
+		// arity is encoded in the type
+		const int arity = start[i].type / 100;
+		if (depth < arity)
+			return -1;
+
+		depth = depth - arity + 1;
+		if (depth > max_depth)
+			max_depth = depth;
+	}
+	return (depth == 1) ? max_depth : -1;
+}
+
 void cModel::Dot(const t_Instruction * start, const unsigned int len)
 {
-	cStack<unsigned int> stack;
+	const int depth = StackDepth(start, len);
+	if (depth < 0)
+	{
+		err << "The program does not leave exactly one value on the stack.\n";
+		return;
+	}
+
+	cStack<unsigned int> stack(depth);
 
 	unsigned int current = 0;
 
@@ -120,18 +158,21 @@ void cModel::Dot(const t_Instruction * start, const unsigned int len)
 
 arg::cArrayConst<t_Instruction> cModel::RandomTree(const unsigned int attribute_count, const unsigned int target_count)
 {
-	cStack<t_Instruction> stack;
-
-	RandomTree(attribute_count, target_count, 0.2, stack, true);
-
 	arg::cArrayConst<t_Instruction> tree;
-	tree.Add(stack.TopPtr(), stack.Count());
+
+	RandomTree(attribute_count, target_count, tree);
 
 	return tree;
 }
 
+void cModel::RandomTree(const unsigned int attribute_count, const unsigned int target_count, arg::cArrayConst<t_Instruction> & tree)
+{
+	tree.ClearCount();
+	RandomTree(attribute_count, target_count, 0.2, tree, true);
+}
+
 void cModel::RandomTree(const unsigned int attribute_count, const unsigned int target_count,
-		double terminal_probability, cStack<t_Instruction> & stack, const bool is_first)
+		double terminal_probability, arg::cArrayConst<t_Instruction> & tree, const bool is_first)
 {
 	t_Instruction node;
 
@@ -150,15 +191,16 @@ void cModel::RandomTree(const unsigned int attribute_count, const unsigned int t
 
 	for (unsigned int i = 0; i < node_arity; i++)
 	{
-		RandomTree(attribute_count, target_count, terminal_probability * 1.1, stack, false);
+		RandomTree(attribute_count, target_count, terminal_probability * 1.1, tree, false);
 	}
 
-	stack.Push(node);
+	tree.Append(node);
 }
 
 void cModel::Compact(arg::cArrayConst<t_Instruction> & instructions)
 {
 	arg::cArrayConst<t_Instruction> compact;
+	compact.Reserve(instructions.Count());
 
 	for (unsigned int i = 0; i < instructions.Count(); i++)
 	{
@@ -167,7 +209,7 @@ void cModel::Compact(arg::cArrayConst<t_Instruction> & instructions)
 			compact.Append(instructions[i]);
 		}
 	}
-	instructions = compact;
+	instructions.Swap(compact);
 }
 
 cModel::~cModel()
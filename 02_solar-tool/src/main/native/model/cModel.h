@@ -80,8 +80,8 @@ class cModel : public arg::cDebuggable
 		/** Represent model instruction in the Dot language. */
 		virtual void DottifyInstruction(const t_Instruction & instruction, cStack<unsigned int> & stack, const unsigned int idx) = 0;
 
-		/** Generate random (sub)tree, it store to stack */
-		void RandomTree(const unsigned int inputs, const unsigned int targets, double terminal_probability, cStack<t_Instruction> & stack, const bool is_first);
+		/** Generate random (sub)tree, it is appended to the tree in RPN */
+		void RandomTree(const unsigned int inputs, const unsigned int targets, double terminal_probability, arg::cArrayConst<t_Instruction> & tree, const bool is_first);
 
 		void RandomTerminalInstruction(t_Instruction & instruction, const unsigned int inputs, const unsigned int targets);
 		inline unsigned int RandomIndex(const unsigned int max_val);
@@ -108,11 +108,16 @@ class cModel : public arg::cDebuggable
 
 		void Print(const t_Instruction * start, const unsigned int len);
 
+		/** \returns Maximal stack depth needed to evaluate the program, -1 if it does not leave exactly one value. */
+		static int StackDepth(const t_Instruction * start, const unsigned int len);
+
 		virtual t_Instruction RandomInstruction(const unsigned int arity, const unsigned int inputs = 0, const unsigned int targets = 0) = 0;
 		virtual t_Instruction ParseInstruction(char* token) = 0;
 		virtual void MutateInstruction(t_Instruction & instruction, const unsigned int inputs, const unsigned int targets) = 0;
 
 		arg::cArrayConst<t_Instruction> RandomTree(const unsigned int inputs, const unsigned int targets);
+		/** Generate a random tree into the given array, its previous items are dropped. */
+		void RandomTree(const unsigned int inputs, const unsigned int targets, arg::cArrayConst<t_Instruction> & tree);
 
 		virtual void Compact(arg::cArrayConst<t_Instruction> & instructions);
 
@@ -0,0 +1,240 @@
+#include "cBatchSim.h"
+
+#include <climits>
+
+cBatchSim::cBatchSim(const cSolarMdlSim * dataset)
+{
+	m_EngPot = dataset->featEngPot();
+	m_EAvg = dataset->featEAvg();
+	m_Length = dataset->getDataLength();
+}
+
+bool cBatchSim::Run(const t_Instruction * const * rules, const unsigned int * lens, const unsigned int count, double * p1, double * p2, const bool simplify)
+{
+	const unsigned int M = m_Length - 1;
+	const unsigned int row_width = 4;
+	const unsigned int input_len = 3;
+
+	bool history[LANES];
+
+	for (unsigned int l = 0; l < count; l++)
+	{
+		if (!m_Plans[l].Compile(rules[l], lens[l], row_width, input_len, simplify))
+			return false;
+
+		m_Eager[l] = m_Plans[l].PastOutput();
+		history[l] = m_Plans[l].PastInput() || m_Plans[l].PastOutput();
+
+		if (history[l])
+		{
+			m_PastInputs[l].Reset(row_width, m_Plans[l].InputDepth());
+			m_PastOutputs[l].Reset(row_width - input_len, m_Plans[l].OutputDepth());
+		}
+	}
+
+	// initSim
+	for (unsigned int l = 0; l < LANES; l++)
+	{
+		m_EsSoc[l] = 0.5f;
+		m_EsEng[l] = m_EsSoc[l] * cMdlPars::C_STORE;
+		m_BuffSize[l] = 0u;
+		m_NextTx[l] = 1u;
+		m_SysReset[l] = false;
+		m_TxOk[l] = false;
+		m_AccBuffSize[l] = 0;
+		m_AccFailMDays[l] = 0;
+		m_LastFailMDay[l] = UINT_MAX;
+
+		for (unsigned int w = 0; w < WINDOWS; w++)
+			m_WinSum[w][l] = 0;
+		for (unsigned int i = 0; i < RING_LEN; i++)
+			m_Ring[i][l] = 0;
+	}
+	m_Head = 0;
+	m_Pushed = 0;
+	m_Resync = RING_LEN;
+
+	Step(0);
+
+	for (unsigned int row_idx = 0; row_idx < M; row_idx++)
+	{
+		// the controllers (per lane, where the output is used or the history is recorded)
+		for (unsigned int l = 0; l < count; l++)
+		{
+			const bool needed = m_Eager[l] || m_TxOk[l];
+
+			if (needed || history[l])
+			{
+				double * input = history[l] ? m_PastInputs[l].Row(row_idx) : m_Row[l];
+				input[0] = SoesAvg(l, 0);
+				input[1] = m_EsSoc[l];
+				input[2] = m_EAvg[row_idx * cMdlPars::EfrEAvgSize];
+
+				double nextTx = 0;
+				if (needed)
+				{
+					double * estimate = history[l] ? m_PastOutputs[l].Row(row_idx) : &m_Row[l][3];
+					*estimate = 0;
+					nextTx = m_Plans[l].Run(input, row_idx, estimate);
+					*estimate = nextTx;
+
+					if (history[l])
+						m_PastOutputs[l].Commit(row_idx);
+				}
+				input[3] = nextTx;
+
+				if (history[l])
+					m_PastInputs[l].Commit(row_idx);
+
+				// simSingleCycleEfr, the output is used only after a successful transmission
+				if (m_TxOk[l])
+				{
+					unsigned short next_tx_period = (unsigned short) (nextTx * cMdlPars::T_TX_MAX + 1);
+					next_tx_period = (next_tx_period < cMdlPars::T_TX_MAX) ? next_tx_period : cMdlPars::T_TX_MAX;
+					m_NextTx[l] = next_tx_period + row_idx;
+				}
+			}
+		}
+
+		#pragma omp simd
+		for (unsigned int l = 0; l < LANES; l++)
+		{
+			m_NextTx[l] = m_SysReset[l] ? cMdlPars::T_TX_MAX + row_idx : m_NextTx[l];
+			m_SysReset[l] = false;
+		}
+
+		Step(row_idx + 1);
+	}
+
+	// calcFitness
+	const unsigned int smpl_per_day = (24 * 60 * 60) / cMdlPars::T_MEAS;
+	const unsigned int day_cnt = (m_Length / smpl_per_day) + (m_Length % smpl_per_day > 0);
+
+	for (unsigned int l = 0; l < count; l++)
+	{
+		p1[l] = ((double) m_AccBuffSize[l] / m_Length) / cMdlPars::BuffSizeMax;
+		p2[l] = (double) m_AccFailMDays[l] / day_cnt;
+	}
+	return true;
+}
+
+/* One simulation step of all lanes (m_evalSolarEnergy, m_evalMeas, m_evalTransmit, m_evalLogging) */
+inline void cBatchSim::Step(const unsigned int step)
+{
+	const double pot = m_EngPot[step];
+	const unsigned int day = step / ((24 * 60 * 60) / (unsigned int) cMdlPars::T_MEAS);
+
+	#pragma omp simd
+	for (unsigned int l = 0; l < LANES; l++)
+	{
+		double eng = m_EsEng[l] + pot;
+		eng = (eng < 0) ? 0 : eng;
+		eng = (eng > cMdlPars::C_STORE) ? cMdlPars::C_STORE : eng;
+
+		// sleep energy
+		eng = eng - cMdlPars::E_SLEEP / cMdlPars::n_DCDC2;
+		eng = (eng < 0) ? 0 : eng;
+
+		// measurement
+		const bool meas_ok = (eng >= ((cMdlPars::E_MEA / cMdlPars::n_DCDC2) + (cMdlPars::E_NVM / cMdlPars::n_DCDC2)));
+		double eng_meas = eng - ((cMdlPars::E_MEA / cMdlPars::n_DCDC2) + (cMdlPars::E_NVM / cMdlPars::n_DCDC2));
+		eng_meas = (eng_meas < 0) ? 0 : eng_meas;
+		eng = meas_ok ? eng_meas : eng;
+
+		unsigned int buff = m_BuffSize[l] + meas_ok;
+		buff = (buff > cMdlPars::BuffSizeMax) ? cMdlPars::BuffSizeMax : buff;
+		bool reset = m_SysReset[l] || !meas_ok;
+
+		// transmission
+		const bool due = (step >= m_NextTx[l]);
+		const unsigned int rem = buff % cMdlPars::Smpl_TX32B;
+		double eng_req_tx = ((buff / cMdlPars::Smpl_TX32B) * (cMdlPars::E_TX32B / cMdlPars::n_DCDC2));
+		const double extra = (rem > 0 && rem <= 2) ? cMdlPars::E_TX8B / cMdlPars::n_DCDC2 : cMdlPars::E_TX32B / cMdlPars::n_DCDC2;
+		eng_req_tx = (rem > 0) ? eng_req_tx + extra : eng_req_tx;
+
+		const bool tx_ok = (eng >= eng_req_tx) & !reset;
+		const bool sent = due && tx_ok;
+
+		double eng_tx = eng - eng_req_tx;
+		eng_tx = (eng_tx < 0) ? 0 : eng_tx;
+		eng = sent ? eng_tx : eng;
+
+		m_TxOk[l] = sent && (buff > 0);
+		buff = sent ? 0u : buff;
+		reset = reset || (due && !tx_ok);
+
+		m_EsEng[l] = eng;
+		m_EsSoc[l] = eng / cMdlPars::C_STORE;
+		m_BuffSize[l] = buff;
+		m_SysReset[l] = reset;
+
+		// fitness accumulators
+		m_AccBuffSize[l] += buff;
+		const bool new_fail_day = !meas_ok && (m_LastFailMDay[l] != day);
+		m_AccFailMDays[l] += new_fail_day;
+		m_LastFailMDay[l] = new_fail_day ? day : m_LastFailMDay[l];
+	}
+
+	PushSoes();
+}
+
+/* cRollingWindows::push for all lanes */
+inline void cBatchSim::PushSoes(void)
+{
+	m_Head = (m_Head + 1 < RING_LEN) ? m_Head + 1 : 0;
+	m_Pushed++;
+
+	#pragma omp simd
+	for (unsigned int l = 0; l < LANES; l++)
+		m_Ring[m_Head][l] = m_EsSoc[l];
+
+	for (unsigned int w = 0; w < WINDOWS; w++)
+	{
+		const unsigned int age_in = w * WINDOW_LEN;
+		const unsigned int age_out = age_in + WINDOW_LEN;
+		const double * in = m_Ring[(m_Head >= age_in) ? m_Head - age_in : m_Head + RING_LEN - age_in];
+		const double * out = m_Ring[(m_Head >= age_out) ? m_Head - age_out : m_Head + RING_LEN - age_out];
+
+		#pragma omp simd
+		for (unsigned int l = 0; l < LANES; l++)
+			m_WinSum[w][l] += in[l] - out[l];
+	}
+
+	if (--m_Resync == 0)
+	{
+		for (unsigned int w = 0; w < WINDOWS; w++)
+		{
+			for (unsigned int l = 0; l < LANES; l++)
+				m_WinSum[w][l] = 0;
+
+			for (unsigned int age = w * WINDOW_LEN; age < (w + 1) * WINDOW_LEN; age++)
+			{
+				const double * val = m_Ring[(m_Head >= age) ? m_Head - age : m_Head + RING_LEN - age];
+
+				#pragma omp simd
+				for (unsigned int l = 0; l < LANES; l++)
+					m_WinSum[w][l] += val[l];
+			}
+		}
+		m_Resync = RING_LEN;
+	}
+}
+
+/* cRollingWindows::average */
+inline double cBatchSim::SoesAvg(const unsigned int lane, const unsigned int window) const
+{
+	const unsigned int offset = window * WINDOW_LEN;
+
+	if (m_Pushed <= offset)
+		return 0;
+
+	unsigned int cnt = m_Pushed - offset;
+	if (cnt > WINDOW_LEN)
+		cnt = WINDOW_LEN;
+
+	return m_WinSum[window][lane] / cnt;
+}
+
+cBatchSim::~cBatchSim(void)
+{
+}
@@ -0,0 +1,88 @@
+/**
+ * \class cBatchSim
+ * \brief Fitness-only simulation of several rules in lockstep over one dataset.
+ *
+ * The run state of cSolarMdlSim is a handful of scalars and the irradiance features are
+ * shared, so up to LANES rules are simulated together over the same time axis. The state
+ * is kept per lane in small arrays and the per-step branches (measurement failure,
+ * transmission, reset) are turned into masked updates in 'omp simd' loops, which the
+ * compiler maps to the vector unit of the target (SSE2 by default, AVX2/AVX-512 with
+ * the matching -march). The rules themselves run per lane on their compiled plans, and
+ * only where the simulator consumes their output (see cEFRModel::Execute).
+ *
+ * The arithmetic follows cSolarMdlSim and cRollingWindows step by step, so P1 and P2 are
+ * bitwise equal to the scalar path.
+ */
+
+#ifndef CBATCHSIM_H_
+#define CBATCHSIM_H_
+
+#include "../solarSim.h"
+#include "../modelParams.h"
+#include "cRulePlan.h"
+#include "cLookback.h"
+
+class cBatchSim
+{
+	public:
+		const static unsigned int LANES = 8;
+
+	private:
+		// stacked SoES windows of the controller input, as set up in cSolarMdlSim
+		const static unsigned int WINDOWS = cMdlPars::EfrSoesAvgSize;
+		const static unsigned int WINDOW_LEN = cMdlPars::EfrSoesAvgSmpls;
+		const static unsigned int RING_LEN = WINDOWS * WINDOW_LEN + 1;
+
+		const double * m_EngPot;
+		const double * m_EAvg;
+		unsigned int m_Length;
+
+		cRulePlan m_Plans[LANES];
+		bool m_Eager[LANES]; ///< the rule reads its past outputs, run it on every row
+
+		// recent inputs and outputs of the rules reading past values
+		cLookback m_PastInputs[LANES];
+		cLookback m_PastOutputs[LANES];
+		double m_Row[LANES][4];
+
+		// run state per lane
+		double m_EsEng[LANES];
+		double m_EsSoc[LANES];
+		unsigned int m_BuffSize[LANES];
+		unsigned int m_NextTx[LANES];
+		bool m_SysReset[LANES];
+		bool m_TxOk[LANES];
+		unsigned long long m_AccBuffSize[LANES];
+		unsigned int m_AccFailMDays[LANES];
+		unsigned int m_LastFailMDay[LANES];
+
+		// SoES rolling windows, the ring position is shared by all lanes
+		double m_Ring[RING_LEN][LANES];
+		double m_WinSum[WINDOWS][LANES];
+		unsigned int m_Head;
+		unsigned int m_Pushed;
+		unsigned int m_Resync;
+
+		inline void Step(const unsigned int step);
+		inline void PushSoes(void);
+		inline double SoesAvg(const unsigned int lane, const unsigned int window) const;
+
+		cBatchSim(const cBatchSim&);
+		cBatchSim& operator=(const cBatchSim&);
+
+	public:
+		/** The batch shares the dataset features of the simulator. */
+		cBatchSim(const cSolarMdlSim * dataset);
+
+		/**
+		 * Simulate up to LANES rules and compute their P1 and P2, the plans are simplified if asked.
+		 * \returns False if any of the rules is malformed.
+		 */
+		bool Run(const t_Instruction * const * rules, const unsigned int * lens, const unsigned int count, double * p1, double * p2, const bool simplify = false);
+
+		unsigned int Length(void) const {return m_Length;};
+
+		~cBatchSim(void);
+};
+
+#endif /* CBATCHSIM_H_ */
@@ -1,10 +1,170 @@
 #include "cEFRModel.h"
+#include "../modelParams.h"
 #include <arg/utils/cRandom.h>
 
+#include <climits>
+#include <cstring>
+#include <fstream>
+
 using namespace std;
 
 cEFRModel::cEFRModel() : m_Solar(NULL)
 {
+	m_StationReducer = REDUCE_MEAN;
+	m_AbortedRuns = 0;
+	m_SavedRows = 0;
+	m_Checkpoints = false;
+	m_ResumedRuns = 0;
+	m_SkippedRows = 0;
+	m_Simplify = false;
+	m_Native = NULL;
+	m_Cache = NULL;
+	m_EvalDB = NULL;
+}
+
+void cEFRModel::FitnessCache(const unsigned int capacity)
+{
+	delete m_Cache;
+	m_Cache = (capacity > 0) ? new cFitnessCache(capacity) : NULL;
+}
+
+void cEFRModel::NativeRules(const char * dir)
+{
+	delete m_Native;
+	m_Native = (dir != NULL) ? new cNativeRules(dir) : NULL;
+}
+
+bool cEFRModel::EvalDB(const char * fname, const unsigned long long capacity)
+{
+	delete m_EvalDB;
+	m_EvalDB = new cEvalDB();
+
+	if (!m_EvalDB->Open(fname, capacity))
+	{
+		err << "Could not open the evaluation database \'" << fname << "\'.\n";
+		delete m_EvalDB;
+		m_EvalDB = NULL;
+		return false;
+	}
+	return true;
+}
+
+bool cEFRModel::EvalKey(const t_Instruction * forest, const unsigned int len, cEvalDB::t_Key & key)
+{
+	if (!cFitnessCache::Digest(forest, len, key.forest))
+		return false;
+
+	// the content of all stations and how they are reduced
+	key.dataset = 14695981039346656037ULL ^ m_StationReducer;
+	for (unsigned int i = 0; i < m_Stations.Count(); i++)
+	{
+		unsigned long long weight;
+		memcpy(&weight, &m_StationWeights[i], sizeof(weight));
+
+		key.dataset = (key.dataset ^ m_Stations[i]->dataHash()) * 1099511628211ULL;
+		if (m_StationReducer == REDUCE_WEIGHTED)
+			key.dataset = (key.dataset ^ weight) * 1099511628211ULL;
+	}
+
+	key.params = cSolarMdlSim::paramsHash();
+	return true;
+}
+
+void cEFRModel::SolarModel(cSolarMdlSim * model)
+{
+	m_Solar = model;
+	m_Stations.Clear();
+	m_StationWeights.Clear();
+	AddStation(model);
+}
+
+void cEFRModel::AddStation(cSolarMdlSim * model, const double weight)
+{
+	if (m_Stations.Count() == MAX_STATIONS)
+	{
+		err << "Too many stations, at most " << MAX_STATIONS << " are supported.\n";
+		delete model;
+		return;
+	}
+
+	m_Stations.Append(model);
+	m_StationWeights.Append(weight);
+
+	// keep the number of contexts, rebuild them with the new station
+	EvalContexts(m_Contexts.Count() > 0 ? m_Contexts.Count() : 1);
+}
+
+unsigned int cEFRModel::Records(void)
+{
+	unsigned int records = 0;
+	for (unsigned int i = 0; i < m_Stations.Count(); i++)
+	{
+		if (m_Stations[i]->getDataLength() > records)
+			records = m_Stations[i]->getDataLength();
+	}
+	return records;
+}
+
+void cEFRModel::EvalContexts(const unsigned int count)
+{
+	ClearContexts();
+
+	// the first context runs on the loaded stations
+	m_Contexts.Append(new cEvalContext(m_Stations, false));
+
+	for (unsigned int i = 1; i < count; i++)
+	{
+		m_Contexts.Append(new cEvalContext(m_Stations, true));
+	}
+}
+
+void cEFRModel::ClearContexts(void)
+{
+	for (unsigned int i = 0; i < m_Contexts.Count(); i++)
+	{
+		delete m_Contexts[i];
+	}
+	m_Contexts.Clear();
+}
+
+cSolarMdlSim * cEFRModel::Solar(const unsigned int station)
+{
+	const unsigned int tid = cEvalContext::ThreadSlot();
+	return (tid < m_Contexts.Count()) ? m_Contexts[tid]->m_Stations[station] : m_Stations[station];
+}
+
+void cEFRModel::ReduceStations(const double * p1, const double * p2, double * P1, double * P2)
+{
+	const unsigned int stations = m_Stations.Count();
+
+	*P1 = *P2 = 0;
+
+	if (m_StationReducer == REDUCE_WORST)
+	{
+		// both criteria are penalties, the worst station has the highest
+		for (unsigned int i = 0; i < stations; i++)
+		{
+			*P1 = (p1[i] > *P1) ? p1[i] : *P1;
+			*P2 = (p2[i] > *P2) ? p2[i] : *P2;
+		}
+	}
+	else
+	{
+		double weights = 0;
+		for (unsigned int i = 0; i < stations; i++)
+		{
+			const double w = (m_StationReducer == REDUCE_WEIGHTED) ? m_StationWeights[i] : 1.0;
+			*P1 += w * p1[i];
+			*P2 += w * p2[i];
+			weights += w;
+		}
+
+		if (weights > 0)
+		{
+			*P1 /= weights;
+			*P2 /= weights;
+		}
+	}
 }
 
 void cEFRModel::DottifyInstruction(const t_Instruction & instruction, cStack<unsigned int> & stack,
@@ -414,16 +574,39 @@ void cEFRModel::MutateInstruction(t_Instruction & instruction, const unsigned in
 
 bool cEFRModel::Execute(const t_Instruction * start, const unsigned int len, cData & data, double * estimates,
 		const unsigned int target_idx)
+{
+	return Execute(start, len, data, estimates, target_idx, 0);
+}
+
+bool cEFRModel::Execute(const t_Instruction * start, const unsigned int len, cData & data, double * estimates,
+		const unsigned int target_idx, const unsigned int station, const cFitnessBound * bound,
+		const cSimCheckpoints * from, cSimCheckpoints * to)
 {
 	// MAKE SURE THAT data has dimension ROWS x 4
 	// and Targets is 1
 
 	(void) target_idx; // this is just to remove the warning
 
-	const unsigned int M = m_Solar->getDataLength() - 1;
+	const unsigned int tid = cEvalContext::ThreadSlot();
+
+	if (tid >= m_Contexts.Count())
+	{
+		err << "No evaluation context for thread " << tid << " (" << m_Contexts.Count() << " prepared).\n";
+		return false;
+	}
+
+	cEvalContext & ctx = *m_Contexts[tid];
+	cSolarMdlSim * solar = ctx.m_Stations[station];
+	cRulePlan & plan = ctx.m_Plan;
+	cLookback & past_inputs = ctx.m_PastInputs[station];
+	cLookback & past_outputs = ctx.m_PastOutputs[station];
+
+	const unsigned int M = solar->getDataLength() - 1;
 	const unsigned int row_width = 4;
 	const unsigned int input_len = 3;
 
+	const unsigned int day_rows = (24 * 60 * 60) / (unsigned int) cMdlPars::T_MEAS;
+
 	double soesAvg, soesCurr, eAvg;
 
 	if (IsDebugging())
@@ -433,43 +616,326 @@ bool cEFRModel::Execute(const t_Instruction * start, const unsigned int len, cDa
 		_dbg << endl;
 	}
 
-	m_Solar->initSimEfr();
+	// the rule is translated once, the rows then run the compiled plan
+	if (!plan.Compile(start, len, row_width, input_len, m_Simplify))
+	{
+		err << "Something went wrong. The rule does not leave exactly one value on the stack.\n";
+		return false;
+	}
+
+	// only the rows the rule looks back at are kept
+	past_inputs.Reset(row_width, plan.InputDepth());
+	past_outputs.Reset(row_width - input_len, plan.OutputDepth());
+
+	// the elites simulated with the full trace again and again run on native code
+	const t_NativeRule native = (m_Native != NULL && solar->fullTrace()) ? m_Native->Rule(plan) : NULL;
+
+	// the output is consumed only after a successful transmission, so the fitness runs skip the other
+	// rows; a rule reading its own past outputs needs them all, past inputs are still recorded every row
+	const bool lazy = !solar->fullTrace() && !plan.PastOutput();
+
+	// the checkpoints are taken at the day boundaries, where the bound is checked too
+	const bool record = lazy && to != NULL;
+	if (record)
+		to->Start(solar, day_rows);
+
+	solar->initSimEfr();
+
+	// a rule reading past inputs needs them from every row, so it cannot skip any
+	unsigned int first_row = 0;
+	if (lazy && !plan.PastInput() && from != NULL && from->Matches(solar, day_rows))
+	{
+		first_row = Resume(plan, solar, *from, record ? to : NULL, bound);
+		if (first_row == UINT_MAX)
+			return true;
+	}
 
 	double nextTx;
 
-	for (unsigned int row_idx = 0; row_idx < M; row_idx++)
+	for (unsigned int row_idx = first_row; row_idx < M; row_idx++)
 	{
+		if (record && row_idx % day_rows == 0)
+			to->Snapshot(solar);
 
-		m_Solar->getCtrlrInputs(&soesAvg, &soesCurr, &eAvg);
+		const bool needed = !lazy || solar->ctrlrNeeded();
 
-		double * input = data.Inputs(row_idx);
-		input[0] = soesAvg;
-		input[1] = soesCurr;
-		input[2] = eAvg;
-	
-		m_Stack.Clear();
-		unsigned int current = 0;
-		do
+		if (needed || plan.PastInput())
 		{
-			ExecuteInstruction(start[current], m_Stack, input, row_idx, row_width, input_len, &estimates[row_idx]);
-			current++;
-		} while (current < len);
+			solar->getCtrlrInputs(&soesAvg, &soesCurr, &eAvg);
 
-		estimates[row_idx] = m_Stack.Top();
-		
-		nextTx = m_Stack.Pop();
-		input[3] = nextTx;
+			double * input = past_inputs.Row(row_idx);
+			input[0] = soesAvg;
+			input[1] = soesCurr;
+			input[2] = eAvg;
 
-		m_Solar->simSingleCycleEfr(nextTx);
+			nextTx = 0;
+			if (needed)
+			{
+				// the output of the current row reads as zero
+				double * estimate = past_outputs.Row(row_idx);
+				*estimate = 0;
+
+				nextTx = (native != NULL) ? native(input, row_idx, estimate) : plan.Run(input, row_idx, estimate);
+				*estimate = nextTx;
+				past_outputs.Commit(row_idx);
+
+				if (estimates != NULL)
+					estimates[row_idx] = nextTx;
+				if (record)
+					to->Decision(row_idx, input, cSolarMdlSim::txPeriod(nextTx));
+			}
+			input[3] = nextTx;
+			past_inputs.Commit(row_idx);
 
-		if (m_Stack.Count() > 0)
+			// the full trace of the first station keeps the inputs for printing
+			if (station == 0 && solar->fullTrace())
+				memcpy(data.Inputs(row_idx), input, sizeof(double) * row_width);
+		}
+		else
 		{
-			err << "Something went wrong. Stack size is " << m_Stack.Count() << " instead of 0.\n";
-			return false;
+			nextTx = 0;
+		}
+
+		solar->simSingleCycleEfr(nextTx);
+
+		// the accumulated P1 and P2 only grow, so they bound the final fitness from above
+		if (bound != NULL && (row_idx + 1) % day_rows == 0)
+		{
+			double p1, p2;
+			solar->calcFitness(&p1, &p2);
+
+			if (bound->Unreachable(p1, p2))
+			{
+				#pragma omp atomic
+				m_AbortedRuns++;
+				#pragma omp atomic
+				m_SavedRows += M - row_idx - 1;
+
+				// the simulator stays unfinished, calcFitness then returns the bounds
+				return true;
+			}
 		}
 	}
 
-	m_Solar->finishSimEfr();
+	solar->finishSimEfr();
+	return true;
+}
+
+unsigned int cEFRModel::Resume(cRulePlan & plan, cSolarMdlSim * solar, const cSimCheckpoints & from,
+		cSimCheckpoints * to, const cFitnessBound * bound)
+{
+	const unsigned int interval = from.Interval();
+
+	if (from.Snapshots() == 0)
+		return 0;
+
+	// the decisions after the last snapshot would not let us skip more
+	const unsigned int last_row = (from.Snapshots() - 1) * interval;
+	unsigned int diverged = last_row;
+
+	for (unsigned int i = 0; i < from.Decisions() && from.Row(i) < last_row; i++)
+	{
+		const unsigned int row = from.Row(i);
+
+		// the rule does not read past values, so the recorded inputs are all it needs
+		const double estimate = 0;
+		const double nextTx = plan.Run(from.Input(i), row, &estimate);
+
+		if (cSolarMdlSim::txPeriod(nextTx) != from.Period(i))
+		{
+			diverged = row;
+			break;
+		}
+	}
+
+	const unsigned int snapshot = diverged / interval;
+
+	// the full run checks the bound at every day boundary of the shared prefix as well
+	if (bound != NULL)
+	{
+		const unsigned int M = solar->getDataLength() - 1;
+
+		for (unsigned int k = 1; k <= snapshot; k++)
+		{
+			double p1, p2;
+			solar->loadState(from.State(k));
+			solar->calcFitness(&p1, &p2);
+
+			if (bound->Unreachable(p1, p2))
+			{
+				if (to != NULL)
+					to->CopyPrefix(from, k);
+
+				#pragma omp atomic
+				m_AbortedRuns++;
+				#pragma omp atomic
+				m_SavedRows += M - k * interval;
+				#pragma omp atomic
+				m_ResumedRuns++;
+				#pragma omp atomic
+				m_SkippedRows += k * interval;
+
+				return UINT_MAX;
+			}
+		}
+	}
+
+	if (to != NULL)
+		to->CopyPrefix(from, snapshot);
+
+	solar->loadState(from.State(snapshot));
+
+	if (snapshot > 0)
+	{
+		#pragma omp atomic
+		m_ResumedRuns++;
+		#pragma omp atomic
+		m_SkippedRows += snapshot * interval;
+	}
+
+	return snapshot * interval;
+}
+
+bool cEFRModel::ExecuteBatch(const t_Instruction * const * rules, const unsigned int * lens, const unsigned int count,
+		double * p1, double * p2)
+{
+	const unsigned int tid = cEvalContext::ThreadSlot();
+
+	if (tid >= m_Contexts.Count())
+	{
+		err << "No evaluation context for thread " << tid << " (" << m_Contexts.Count() << " prepared).\n";
+		return false;
+	}
+
+	cEvalContext & ctx = *m_Contexts[tid];
+
+	if (ctx.m_Batch == NULL)
+		ctx.m_Batch = new cBatchSim(ctx.m_Stations[0]);
+
+	if (!ctx.m_Batch->Run(rules, lens, count, p1, p2, m_Simplify))
+	{
+		err << "Something went wrong. A rule does not leave exactly one value on the stack.\n";
+		return false;
+	}
+	return true;
+}
+
+void cEFRModel::PrintSimplified(const t_Instruction * start, const unsigned int len)
+{
+	cRulePlan plan;
+	unsigned int original = 0;
+
+	for (unsigned int i = 0; i < len; i++)
+	{
+		if (start[i].type != NOOP_INSTRUCTION)
+			original++;
+	}
+
+	if (!plan.Compile(start, len, 4, 3, true))
+	{
+		err << "The rule does not leave exactly one value on the stack.\n";
+		return;
+	}
+
+	plan.Print();
+	cout << "(" << plan.Steps() << " of " << original << " steps)";
+}
+
+bool cEFRModel::Export(const t_Instruction * start, const unsigned int len, const char * fname, const char * name, const bool single)
+{
+	const char * type = single ? "float" : "double";
+	cRulePlan plan;
+
+	if (!plan.Compile(start, len, 4, 3, true))
+	{
+		err << "The rule does not leave exactly one value on the stack.\n";
+		return false;
+	}
+
+	// the interface gives the inputs of the current row only
+	if (plan.PastInput() || plan.PastOutput())
+	{
+		err << "Rules reading past inputs or outputs cannot be exported.\n";
+		return false;
+	}
+
+	ofstream code(fname);
+
+	code << "/*\n";
+	code << " * " << name << " - EFR controller exported by solar-tool, " << plan.Steps() << " steps in " << type << ".\n";
+	code << " *\n";
+	code << " * soes_avg  - average state of the energy storage (EfrSoesAvgSmpls steps)\n";
+	code << " * soes_curr - current state of the energy storage\n";
+	code << " * e_avg     - average potential energy (EfrEAvgSmpls steps) / EfrEAvgMaxVal\n";
+	code << " *\n";
+	code << " * Returns the next transmit period as a fraction of T_TX_MAX. No state, no allocation.\n";
+	code << " */\n\n";
+
+	plan.Source(code, (string(name) + "_plan").c_str(), single, true);
+
+	code << "\n" << type << " " << name << "(const " << type << " soes_avg, const " << type << " soes_curr, const " << type << " e_avg)\n";
+	code << "{\n";
+	code << "\tconst " << type << " input[3] = {soes_avg, soes_curr, e_avg};\n";
+	code << "\treturn " << name << "_plan(input, 0, 0);\n";
+	code << "}\n";
+	code.close();
+
+	string replay = fname;
+	const size_t slash = replay.find_last_of("/\\");
+	replay = replay.substr(0, (slash == string::npos) ? 0 : slash + 1) + name + "_replay.cpp";
+
+	ofstream harness(replay.c_str());
+
+	harness << "/*\n";
+	harness << " * Replay of the exported controller " << name << " in the simulator, prints P1, P2 and the run statistics\n";
+	harness << " * to compare with the query of the same rule (solar -query ... -file data.csv).\n";
+	harness << " *\n";
+	harness << " * c++ -O2 -I<native> " << replay.substr(replay.find_last_of("/\\") + 1) << " <native>/model/solarSim.cpp \\\n";
+	harness << " *     <native>/model/rollingWindows.cpp <native>/model/simTrace.cpp -o " << name << "_replay\n";
+	harness << " */\n\n";
+	harness << "#include \"model/solarSim.h\"\n\n";
+	harness << "extern \"C\" {\n";
+	harness << "#include \"" << string(fname).substr(string(fname).find_last_of("/\\") + 1) << "\"\n";
+	harness << "}\n\n";
+	harness << "class cExportedCtrl : public cEfrCtrlI\n";
+	harness << "{\n";
+	harness << "public:\n";
+	harness << "    double efrCompute(double soes_avg[], double soes_curr, double e_avg[]) override\n";
+	harness << "    {\n";
+	harness << "        return " << name << "(soes_avg[0], soes_curr, e_avg[0]);\n";
+	harness << "    }\n";
+	harness << "};\n\n";
+	harness << "int main(int argc, char * argv[])\n";
+	harness << "{\n";
+	harness << "    if(argc < 2)\n";
+	harness << "    {\n";
+	harness << "        std::cerr << \"Usage: \" << argv[0] << \" data.csv\\n\";\n";
+	harness << "        return 1;\n";
+	harness << "    }\n\n";
+	harness << "    cExportedCtrl ctrl;\n";
+	harness << "    cSolarMdlSim sim(&ctrl);\n\n";
+	harness << "    if(!sim.loadDataFile(argv[1]))\n";
+	harness << "    {\n";
+	harness << "        std::cerr << \"Could not load \" << argv[1] << \"\\n\";\n";
+	harness << "        return 1;\n";
+	harness << "    }\n\n";
+	harness << "    sim.fullTrace(true);\n";
+	harness << "    sim.simRunEfr();\n\n";
+	harness << "    double p1, p2;\n";
+	harness << "    cSimStats stats;\n";
+	harness << "    sim.calcFitness(&p1, &p2);\n";
+	harness << "    sim.calcStats(&stats);\n\n";
+	harness << "    std::cout << \"P1 = \" << p1 << \"\\nP2 = \" << p2 << \"\\n\";\n";
+	harness << "    stats.print();\n";
+	harness << "    return 0;\n";
+	harness << "}\n";
+	harness.close();
+
+	if (!code || !harness)
+	{
+		err << "Could not write '" << fname << "' or '" << replay << "'.\n";
+		return false;
+	}
 	return true;
 }
 
@@ -510,7 +976,14 @@ double cEFRModel::ExecuteOnce(const t_Instruction * start, const unsigned int le
 
 cEFRModel::~cEFRModel()
 {
-	if (m_Solar != NULL)
-		delete m_Solar;
+	ClearContexts();
+	delete m_Cache;
+	delete m_EvalDB;
+	delete m_Native;
+
+	for (unsigned int i = 0; i < m_Stations.Count(); i++)
+	{
+		delete m_Stations[i];
+	}
 }
 
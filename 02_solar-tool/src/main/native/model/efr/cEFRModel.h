@@ -2,14 +2,76 @@
 #define CEFRMODEL_H_
 
 #include "../cModel.h"
+#include "../cFitnessCache.h"
+#include "../cEvalDB.h"
 #include "../solarSim.h"
+#include "cEvalContext.h"
+#include "cSimCheckpoints.h"
+#include "cNativeRules.h"
+
+/**
+ * Tells a running simulation whether it can stop early. It gets lower bounds of P1 and P2
+ * (the final values can only be higher) and answers whether the fitness they allow is too low.
+ */
+class cFitnessBound
+{
+	public:
+		virtual bool Unreachable(const double p1, const double p2) const = 0;
+		virtual ~cFitnessBound(void) {};
+};
 
 class cEFRModel: public cModel
 {
 	public:
+		typedef enum {
+			REDUCE_MEAN = 0,
+			REDUCE_WORST,
+			REDUCE_WEIGHTED,
+		} t_StationReducer;
+
+		const static unsigned int MAX_STATIONS = 32;
+
 		cSolarMdlSim * m_Solar;
 
 	private:
+		// the stations (datasets) a rule is evaluated on, station 0 is m_Solar
+		arg::cArrayConst<cSolarMdlSim*> m_Stations;
+		arg::cArrayConst<double> m_StationWeights;
+		t_StationReducer m_StationReducer;
+
+		// one evaluation context per thread, context 0 wraps the stations
+		arg::cArrayConst<cEvalContext*> m_Contexts;
+
+		// evaluations stopped by a fitness bound and the rows they did not simulate
+		unsigned long m_AbortedRuns;
+		unsigned long m_SavedRows;
+
+		// fitness only runs record checkpoints, the runs resumed from them and the rows they skipped
+		bool m_Checkpoints;
+		unsigned long m_ResumedRuns;
+		unsigned long m_SkippedRows;
+
+		// the plans are simplified before every evaluation
+		bool m_Simplify;
+
+		// the full trace runs use the rules compiled to machine code (NULL if disabled)
+		cNativeRules * m_Native;
+
+		// P1 and P2 of the forests evaluated so far (NULL if disabled)
+		cFitnessCache * m_Cache;
+
+		// results of the previous runs on disk (NULL if not used)
+		cEvalDB * m_EvalDB;
+
+		void ClearContexts(void);
+
+		/**
+		 * Run the rule on the decisions recorded in the checkpoints and restore the simulator at the
+		 * last snapshot before the first different one. The prefix is copied to the new record (if any).
+		 * \returns The row to continue from, or UINT_MAX if the bound stopped the run within the prefix.
+		 */
+		unsigned int Resume(cRulePlan & plan, cSolarMdlSim * solar, const cSimCheckpoints & from, cSimCheckpoints * to, const cFitnessBound * bound);
+
 		virtual bool ExecuteInstruction(const t_Instruction & instruction, cStack<double> & stack, const double * input, const unsigned int row_idx, const unsigned int row_width, const unsigned int input_len, double * estimates);
 		virtual void PrintInstruction(const t_Instruction & instruction);
 		virtual t_Instruction RandomInstruction(const unsigned int inputs, const unsigned int targets, const double terminal_probability);
@@ -20,14 +82,81 @@ class cEFRModel: public cModel
 	public:
 		cEFRModel(void);
 
-		void SolarModel(cSolarMdlSim * model) {m_Solar = model;};
+		void SolarModel(cSolarMdlSim * model);
 		cSolarMdlSim * VideoModel(void) {return m_Solar;};
 
+		/** Prepare evaluation contexts for the given number of threads. */
+		void EvalContexts(const unsigned int count);
+		unsigned int EvalContexts(void) {return m_Contexts.Count();};
+
+		/** Add another station, the rules are then evaluated on all stations. */
+		void AddStation(cSolarMdlSim * model, const double weight = 1.0);
+		unsigned int Stations(void) {return m_Stations.Count();};
+		/** \returns Length of the longest station dataset. */
+		unsigned int Records(void);
+
+		void StationReducer(const t_StationReducer val) {m_StationReducer = val;};
+		void StationWeight(const unsigned int station, const double val) {m_StationWeights[station] = val;};
+
+		/** Aggregate per-station P1 and P2 by the configured reducer. */
+		void ReduceStations(const double * p1, const double * p2, double * P1, double * P2);
+
+		/** \returns The simulator of given station used by the calling thread. */
+		cSolarMdlSim * Solar(const unsigned int station = 0);
+
 		virtual t_Instruction RandomInstruction(const unsigned int arity, const unsigned int inputs = 0, const unsigned int targets = 0);
 		virtual t_Instruction ParseInstruction(char* token);
 		virtual void MutateInstruction(t_Instruction & instruction, const unsigned int inputs, const unsigned int targets);
 
 		virtual bool Execute(const t_Instruction * start, const unsigned int len, cData & data, double * estimates, const unsigned int target_idx);
+		/**
+		 * Evaluate on a station, the run stops at a day boundary once the bound (if any) is unreachable.
+		 * A fitness only run resumes from the checkpoints of a previous run (from) where the rule makes
+		 * the same decisions, and records its own checkpoints (to). The past values the rule reads are
+		 * kept in the context, the outputs of the computed rows are stored to estimates unless it is NULL.
+		 */
+		bool Execute(const t_Instruction * start, const unsigned int len, cData & data, double * estimates, const unsigned int target_idx, const unsigned int station, const cFitnessBound * bound = NULL, const cSimCheckpoints * from = NULL, cSimCheckpoints * to = NULL);
+
+		/**
+		 * Evaluate up to cBatchSim::LANES rules in lockstep on the first station (fitness only).
+		 * \returns False if any of the rules is malformed.
+		 */
+		bool ExecuteBatch(const t_Instruction * const * rules, const unsigned int * lens, const unsigned int count, double * p1, double * p2);
+
+		unsigned long AbortedRuns(void) {return m_AbortedRuns;};
+		unsigned long SavedRows(void) {return m_SavedRows;};
+
+		void Checkpoints(const bool val) {m_Checkpoints = val;};
+		bool Checkpoints(void) {return m_Checkpoints;};
+		unsigned long ResumedRuns(void) {return m_ResumedRuns;};
+		unsigned long SkippedRows(void) {return m_SkippedRows;};
+
+		/** Simplify the plans of all evaluations, see cRulePlan. */
+		void Simplify(const bool val) {m_Simplify = val;};
+		bool Simplify(void) {return m_Simplify;};
+		/** Print the simplified plan of a rule with the shared values in registers. */
+		void PrintSimplified(const t_Instruction * start, const unsigned int len);
+
+		/**
+		 * Export a rule as the C function name(soes_avg, soes_curr, e_avg) in double or single precision
+		 * to the given file, with a replay harness that runs it in cSolarMdlSim (name_replay.cpp).
+		 * \returns False if the rule reads past values, or a file cannot be written.
+		 */
+		bool Export(const t_Instruction * start, const unsigned int len, const char * fname, const char * name, const bool single = false);
+
+		/** Run the full trace simulations with native rules built in the given directory, NULL disables them. */
+		void NativeRules(const char * dir);
+		cNativeRules * NativeRules(void) {return m_Native;};
+
+		/** Memoize P1 and P2 of up to the given number of forests, 0 disables the cache. */
+		void FitnessCache(const unsigned int capacity);
+		cFitnessCache * FitnessCache(void) {return m_Cache;};
+
+		/** Use the evaluation database in the given file, it is created with the capacity if missing. */
+		bool EvalDB(const char * fname, const unsigned long long capacity = cEvalDB::DEFAULT_CAPACITY);
+		cEvalDB * EvalDB(void) {return m_EvalDB;};
+		/** Key of a forest evaluated on the stations, \returns False for a malformed forest. */
+		bool EvalKey(const t_Instruction * forest, const unsigned int len, cEvalDB::t_Key & key);
 
 		double ExecuteOnce(const t_Instruction * start, const unsigned int len, const double * input, const unsigned int input_len, double * estimates);
 
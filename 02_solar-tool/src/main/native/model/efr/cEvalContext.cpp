@@ -0,0 +1,51 @@
+#include "cEvalContext.h"
+
+cEvalContext::cEvalContext(arg::cArrayConst<cSolarMdlSim*> & stations, const bool owner) :
+		m_Owner(owner), m_Batch(NULL)
+{
+	for (unsigned int i = 0; i < stations.Count(); i++)
+	{
+		cSolarMdlSim * solar = stations[i];
+
+		if (m_Owner)
+		{
+			solar = new cSolarMdlSim();
+			solar->shareDataSet(stations[i]);
+		}
+		m_Stations.Append(solar);
+
+		// evaluations only need the fitness, the trace is kept for the stats of the main simulators
+		solar->fullTrace(false);
+
+		cSimTrace * trace = NULL;
+		if (!m_Owner)
+		{
+			trace = new cSimTrace(solar->getDataLength());
+			solar->attachTrace(trace);
+		}
+		m_Traces.Append(trace);
+	}
+
+	// the stations may run concurrently, each keeps its own lookback
+	m_PastInputs = new cLookback[stations.Count()];
+	m_PastOutputs = new cLookback[stations.Count()];
+}
+
+cEvalContext::~cEvalContext()
+{
+	for (unsigned int i = 0; i < m_Stations.Count(); i++)
+	{
+		if (m_Owner)
+			delete m_Stations[i];
+		else
+		{
+			m_Stations[i]->attachTrace(NULL);
+			m_Stations[i]->fullTrace(true);
+		}
+
+		delete m_Traces[i];
+	}
+	delete[] m_PastInputs;
+	delete[] m_PastOutputs;
+	delete m_Batch;
+}
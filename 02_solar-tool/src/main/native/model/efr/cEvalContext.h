@@ -0,0 +1,56 @@
+/**
+ * \class cEvalContext
+ * \brief Per-thread state needed to evaluate a rule on the solar model.
+ *
+ * Each worker thread owns one context with its own simulator run state (one simulator
+ * per station), compiled rule plan and the lookback of the past controller inputs and
+ * outputs per station. The loaded datasets are
+ * shared read-only by all simulators, so any number of rules can be evaluated concurrently.
+ * The simulators run in the fitness only mode; the first (non-owner) context keeps a trace
+ * per station, allocated once and reused, for the runs that need the full trace.
+ */
+
+#ifndef CEVALCONTEXT_H_
+#define CEVALCONTEXT_H_
+
+#include "../solarSim.h"
+#include "cRulePlan.h"
+#include "cBatchSim.h"
+#include "cLookback.h"
+
+#include <arg/core/cArray.h>
+
+#include <omp.h>
+
+class cEvalContext
+{
+		bool m_Owner;
+
+	public:
+		arg::cArrayConst<cSolarMdlSim*> m_Stations;
+		arg::cArrayConst<cSimTrace*> m_Traces; ///< Output trace of each station simulator (NULL in owner contexts)
+		cLookback * m_PastInputs;  ///< Recent controller inputs of each station
+		cLookback * m_PastOutputs; ///< Recent controller outputs of each station
+
+		cRulePlan m_Plan;
+		cBatchSim * m_Batch; ///< Lockstep simulator of the first station, created on first use
+
+		/**
+		 * The owner context gets private simulators sharing the datasets of the stations,
+		 * otherwise the stations are used directly. The traces are owned by the context.
+		 */
+		cEvalContext(arg::cArrayConst<cSolarMdlSim*> & stations, const bool owner);
+
+		/** \returns Index of the context that belongs to the calling thread. */
+		static inline unsigned int ThreadSlot(void);
+
+		~cEvalContext();
+};
+
+inline unsigned int cEvalContext::ThreadSlot(void)
+{
+	// nested regions are serialized, so they run in the context of their outermost thread
+	return (omp_get_level() > 0) ? omp_get_ancestor_thread_num(1) : 0;
+}
+
+#endif /* CEVALCONTEXT_H_ */
@@ -0,0 +1,26 @@
+#include "cLookback.h"
+
+cLookback::cLookback(void) : m_Rows(NULL), m_Width(0), m_Depth(0), m_Capacity(0)
+{
+}
+
+void cLookback::Reset(const unsigned int width, const unsigned int depth)
+{
+	const unsigned int size = 2 * width * depth;
+
+	if (size > m_Capacity)
+	{
+		delete[] m_Rows;
+		m_Rows = new double[size];
+		m_Capacity = size;
+	}
+
+	m_Width = width;
+	m_Depth = depth;
+	memset(m_Rows, 0, sizeof(double) * size);
+}
+
+cLookback::~cLookback(void)
+{
+	delete[] m_Rows;
+}
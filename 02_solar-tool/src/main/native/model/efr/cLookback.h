@@ -0,0 +1,53 @@
+/**
+ * \class cLookback
+ * \brief The last rows of a rule evaluation, for the rules reading past inputs or outputs.
+ *
+ * A rule looks at most a few rows back (the extra_uint of PAST_INPUT and PAST_OUTPUT), so
+ * only that many rows are kept instead of the whole run. The ring holds depth rows and
+ * stores each of them twice, in its slot and one depth further. The current row and the
+ * depth - 1 rows before it are then always contiguous, so the compiled plan reads them by
+ * the same negative offsets as in a full-length buffer.
+ */
+
+#ifndef CLOOKBACK_H_
+#define CLOOKBACK_H_
+
+#include <cstring>
+
+class cLookback
+{
+		double * m_Rows;
+		unsigned int m_Width;
+		unsigned int m_Depth;
+		unsigned int m_Capacity;
+
+		cLookback(const cLookback&);
+		cLookback& operator=(const cLookback&);
+
+	public:
+		cLookback(void);
+
+		/** Keep the given number of rows of given width, all of them zero. */
+		void Reset(const unsigned int width, const unsigned int depth);
+
+		/** \returns The row to write, the depth - 1 rows before it are readable below it. */
+		inline double * Row(const unsigned int row_idx);
+		/** Mirror the row once it is written, before the next row is started. */
+		inline void Commit(const unsigned int row_idx);
+
+		~cLookback(void);
+};
+
+inline double * cLookback::Row(const unsigned int row_idx)
+{
+	return m_Rows + ((row_idx % m_Depth) + m_Depth) * m_Width;
+}
+
+inline void cLookback::Commit(const unsigned int row_idx)
+{
+	// the rows wrapping around the ring are read from the lower copy
+	if (m_Depth > 1)
+		memcpy(m_Rows + (row_idx % m_Depth) * m_Width, Row(row_idx), sizeof(double) * m_Width);
+}
+
+#endif /* CLOOKBACK_H_ */
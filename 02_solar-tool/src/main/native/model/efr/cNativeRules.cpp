@@ -0,0 +1,177 @@
+#include "cNativeRules.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#ifndef _MSC_VER
+	#include <dlfcn.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// the flags keep the arithmetic of the interpreter
+static const char * NATIVE_FLAGS = "-O2 -fPIC -shared -ffp-contract=off -fno-fast-math";
+static const char * NATIVE_SYMBOL = "solar_rule";
+
+cNativeRules::cNativeRules(const char * dir) : m_Dir(dir)
+{
+	const char * compiler = getenv("CXX");
+	m_Compiler = (compiler != NULL && compiler[0] != '\0') ? compiler : "c++";
+
+	m_Compiled = 0;
+	m_Loaded = 0;
+	m_Failed = 0;
+
+#ifndef _MSC_VER
+	// a missing directory is created, an existing one is fine
+	mkdir(dir, 0755);
+#endif
+}
+
+void cNativeRules::Hash(const std::string & text, unsigned long long hash[2])
+{
+	// FNV-1a and the same with a multiply-xorshift mix
+	hash[0] = 14695981039346656037ULL;
+	hash[1] = 0x9E3779B97F4A7C15ULL;
+
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		const unsigned char c = text[i];
+
+		hash[0] = (hash[0] ^ c) * 1099511628211ULL;
+		hash[1] = (hash[1] ^ c) * 0xBF58476D1CE4E5B9ULL;
+		hash[1] ^= hash[1] >> 31;
+	}
+}
+
+t_NativeRule cNativeRules::Rule(const cRulePlan & plan)
+{
+	std::ostringstream source;
+	unsigned long long hash[2];
+	t_NativeRule rule = NULL;
+
+	source << "// " << m_Compiler << " " << NATIVE_FLAGS << "\n";
+	source << "extern \"C\" {\n\n";
+	plan.Source(source, NATIVE_SYMBOL);
+	source << "\n}\n";
+
+	// the compiler and its flags are part of the source, so of the hash
+	const std::string text = source.str();
+	Hash(text, hash);
+
+	#pragma omp critical(native_rules)
+	{
+		bool known = false;
+
+		for (unsigned int i = 0; i < m_Entries.Count() && !known; i++)
+		{
+			const t_Entry & entry = *m_Entries.GetArray(i);
+			if (entry.hash[0] == hash[0] && entry.hash[1] == hash[1])
+			{
+				rule = entry.rule;
+				known = true;
+			}
+		}
+
+		if (!known)
+		{
+			t_Entry entry;
+			entry.hash[0] = hash[0];
+			entry.hash[1] = hash[1];
+			entry.rule = Build(text, hash, &entry.handle);
+			rule = entry.rule;
+
+			m_Entries.Append(entry);
+		}
+	}
+	return rule;
+}
+
+#ifndef _MSC_VER
+
+t_NativeRule cNativeRules::Build(const std::string & source, const unsigned long long hash[2], void ** handle)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "/rule_%016llx%016llx", hash[0], hash[1]);
+
+	const std::string base = m_Dir + name;
+	const std::string object = base + ".so";
+
+	*handle = NULL;
+
+	// an object built by an earlier or a concurrent run is used as it is
+	if (access(object.c_str(), R_OK) != 0)
+	{
+		std::ostringstream tmp;
+		tmp << base << "." << getpid();
+
+		const std::string tmp_source = tmp.str() + ".cpp";
+		const std::string tmp_object = tmp.str() + ".so";
+		const std::string log = base + ".log";
+
+		std::ofstream out(tmp_source.c_str());
+		out << source;
+		out.close();
+
+		const std::string command = m_Compiler + " " + NATIVE_FLAGS + " -o \"" + tmp_object + "\" \"" + tmp_source + "\" > \"" + log + "\" 2>&1";
+
+		// the object appears under its name complete, the other processes never load a partial one
+		if (!out || system(command.c_str()) != 0 || rename(tmp_object.c_str(), object.c_str()) != 0)
+		{
+			err << "Could not compile the rule, see \'" << log << "\'.\n";
+			remove(tmp_source.c_str());
+			remove(tmp_object.c_str());
+			m_Failed++;
+			return NULL;
+		}
+
+		rename(tmp_source.c_str(), (base + ".cpp").c_str());
+		remove(log.c_str());
+		m_Compiled++;
+	}
+
+	*handle = dlopen(object.c_str(), RTLD_NOW | RTLD_LOCAL);
+	void * symbol = (*handle != NULL) ? dlsym(*handle, NATIVE_SYMBOL) : NULL;
+
+	if (symbol == NULL)
+	{
+		const char * error = dlerror();
+		err << "Could not load the rule \'" << object << "\': " << ((error != NULL) ? error : "no symbol") << ".\n";
+		if (*handle != NULL)
+			dlclose(*handle);
+		*handle = NULL;
+		m_Failed++;
+		return NULL;
+	}
+
+	m_Loaded++;
+	return (t_NativeRule) symbol;
+}
+
+cNativeRules::~cNativeRules(void)
+{
+	for (unsigned int i = 0; i < m_Entries.Count(); i++)
+	{
+		if (m_Entries.GetArray(i)->handle != NULL)
+			dlclose(m_Entries.GetArray(i)->handle);
+	}
+}
+
+#else
+
+t_NativeRule cNativeRules::Build(const std::string & source, const unsigned long long hash[2], void ** handle)
+{
+	(void) source;
+	(void) hash;
+	*handle = NULL;
+	m_Failed++;
+	return NULL;
+}
+
+cNativeRules::~cNativeRules(void)
+{
+}
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * \class cNativeRules
+ * \brief Rules compiled to machine code by the system compiler and loaded at run time.
+ *
+ * The runs that re-simulate the same elite many times (the run statistics of -vv, the final
+ * statistics, the evaluation on several stations) spend their time in the interpreted plan.
+ * The plan of such a rule is written as a C++ function (cRulePlan::Source), compiled into a
+ * shared object in the given directory and loaded by dlopen. The objects are named by the
+ * hash of their source, so the later runs load them without compiling. Loaded rules are
+ * kept in memory until the end of the run.
+ *
+ * The compiler is taken from the environment variable CXX (c++ if not set), the build uses
+ * no fast math and no contraction, so the native rules give bitwise the same outputs as
+ * cRulePlan::Run. A rule that fails to compile is evaluated by the interpreter.
+ *
+ * Needs POSIX dlopen, on other platforms no rule is compiled.
+ */
+
+#ifndef CNATIVERULES_H_
+#define CNATIVERULES_H_
+
+#include "cRulePlan.h"
+
+#include <arg/core/cArray.h>
+#include <arg/core/cDebuggable.h>
+
+#include <string>
+
+typedef double (*t_NativeRule)(const double * input, const unsigned int row_idx, const double * estimate);
+
+class cNativeRules : public arg::cDebuggable
+{
+		struct t_Entry
+		{
+			unsigned long long hash[2];
+			void * handle;
+			t_NativeRule rule; ///< NULL if the rule could not be built
+		};
+
+		std::string m_Dir;
+		std::string m_Compiler;
+
+		arg::cArrayConst<t_Entry> m_Entries;
+
+		unsigned long m_Compiled;
+		unsigned long m_Loaded;
+		unsigned long m_Failed;
+
+		static void Hash(const std::string & text, unsigned long long hash[2]);
+		/** Compile the source (if the object is missing) and load it, \returns NULL on failure. */
+		t_NativeRule Build(const std::string & source, const unsigned long long hash[2], void ** handle);
+
+	public:
+		/** The shared objects are kept in the given directory. */
+		cNativeRules(const char * dir);
+
+		/** \returns The native function of the plan, or NULL if it cannot be built. */
+		t_NativeRule Rule(const cRulePlan & plan);
+
+		unsigned long Compiled(void) const {return m_Compiled;};
+		unsigned long Loaded(void) const {return m_Loaded;};
+		unsigned long Failed(void) const {return m_Failed;};
+
+		~cNativeRules(void);
+};
+
+#endif /* CNATIVERULES_H_ */
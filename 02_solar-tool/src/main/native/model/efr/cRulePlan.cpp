@@ -0,0 +1,394 @@
+#include "cRulePlan.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+cRulePlan::cRulePlan(void) : m_Operands(NULL), m_Capacity(0), m_Registers(NULL), m_RegisterCapacity(0), m_RegisterCount(0),
+		m_InputLen(0), m_PastInput(false), m_PastOutput(false), m_InputBack(0), m_OutputBack(0)
+{
+}
+
+bool cRulePlan::Compile(const t_Instruction * start, const unsigned int len, const unsigned int row_width, const unsigned int input_len, const bool simplify)
+{
+	const int targets = row_width - input_len;
+	int depth = cModel::StackDepth(start, len);
+
+	if (depth < 0)
+		return false;
+
+	m_Steps.ClearCount();
+	m_RegisterCount = 0;
+	m_InputLen = input_len;
+
+	for (unsigned int i = 0; i < len; i++)
+	{
+		const t_Instruction & instruction = start[i];
+		t_Step step;
+
+		step.value = instruction.value;
+		step.back = instruction.extra_uint;
+		step.offset = 0;
+
+		switch (instruction.type)
+		{
+		case NOOP_INSTRUCTION:
+			continue;
+		case INPUT_INSTRUCTION:
+			step.op = OP_INPUT;
+			break;
+		case PAST_INPUT_INSTRUCTION:
+			step.op = OP_PAST_INPUT;
+			step.offset = -(int) (step.back * row_width);
+			break;
+		case PAST_OUTPUT_INSTRUCTION:
+			step.op = OP_PAST_OUTPUT;
+			step.offset = -(int) (step.back * targets);
+			break;
+		case NOT_INSTRUCTION:
+			step.op = OP_NOT;
+			break;
+		case AND_INSTRUCTION:
+			step.op = OP_AND;
+			break;
+		case OR_INSTRUCTION:
+			step.op = OP_OR;
+			break;
+		case SUM_INSTRUCTION:
+			step.op = OP_SUM;
+			break;
+		case PROD_INSTRUCTION:
+			step.op = OP_PROD;
+			break;
+		default:
+			return false;
+		}
+
+		const double a = instruction.weight;
+		step.a = a;
+		step.P_a = (1 + a) / 2.0;
+		step.Q_a = (1 - a * a) / 4.0;
+		step.one_minus_a = 1.0 - a;
+
+		m_Steps.Append(step);
+	}
+
+	if (simplify)
+		depth = Simplify();
+
+	ScanPast();
+
+	if (m_RegisterCount > m_RegisterCapacity)
+	{
+		delete[] m_Registers;
+		m_RegisterCapacity = m_RegisterCount;
+		m_Registers = new double[m_RegisterCapacity];
+	}
+
+	if ((unsigned int) depth > m_Capacity)
+	{
+		delete[] m_Operands;
+		m_Capacity = depth;
+		m_Operands = new double[m_Capacity];
+	}
+	return true;
+}
+
+bool cRulePlan::SameValue(const t_Node & node, const t_Step & step, const int left, const int right)
+{
+	// the weights are compared bitwise, 0.0 and -0.0 divide differently
+	return node.step.op == step.op && node.step.value == step.value && node.step.back == step.back
+			&& memcmp(&node.step.a, &step.a, sizeof(double)) == 0 && node.left == left && node.right == right;
+}
+
+unsigned int cRulePlan::Simplify(void)
+{
+	arg::cArrayConst<t_Node> nodes;
+	arg::cArrayConst<int> stack;
+
+	// value numbering, the nodes come in the order of the steps, operands first
+	for (unsigned int i = 0; i < m_Steps.Count(); i++)
+	{
+		t_Step step = m_Steps[i];
+		int left = -1;
+		int right = -1;
+
+		// only the fields the step uses are compared
+		if (step.op == OP_PAST_INPUT && step.back == 0)
+			step.op = OP_INPUT; // 0 rows back is the current row in both branches
+		if (step.op != OP_PAST_INPUT && step.op != OP_PAST_OUTPUT)
+			step.back = step.offset = 0;
+		if (step.op > OP_PAST_OUTPUT)
+			step.value = 0;
+
+		switch (step.op)
+		{
+		case OP_NOT:
+			left = stack[stack.Count() - 1];
+			stack.Left(stack.Count() - 1);
+			break;
+		case OP_AND:
+		case OP_OR:
+		case OP_SUM:
+		case OP_PROD:
+			right = stack[stack.Count() - 1];
+			left = stack[stack.Count() - 2];
+			stack.Left(stack.Count() - 2);
+
+			// min(x, x) and max(x, x) are x
+			if (left == right && (step.op == OP_AND || step.op == OP_OR))
+			{
+				step.op = OP_THRESHOLD;
+				right = -1;
+			}
+			break;
+		default:
+			break;
+		}
+
+		int id = -1;
+		for (unsigned int n = 0; n < nodes.Count() && id < 0; n++)
+		{
+			if (SameValue(nodes[n], step, left, right))
+				id = n;
+		}
+
+		if (id < 0)
+		{
+			t_Node node;
+			node.step = step;
+			node.left = left;
+			node.right = right;
+			node.uses = 0;
+			node.reg = -1;
+
+			id = nodes.Count();
+			nodes.Append(node);
+		}
+		stack.Append(id);
+	}
+
+	// the uses by the nodes that are computed, a parent always comes after its operands
+	const int root = stack[0];
+	nodes[root].uses = 1;
+
+	for (int n = root; n >= 0; n--)
+	{
+		if (nodes[n].uses == 0)
+			continue;
+		if (nodes[n].left >= 0)
+			nodes[nodes[n].left].uses++;
+		if (nodes[n].right >= 0)
+			nodes[nodes[n].right].uses++;
+	}
+
+	unsigned int depth = 0;
+	unsigned int max_depth = 0;
+
+	m_Steps.ClearCount();
+	Emit(nodes, root, depth, max_depth);
+
+	return max_depth;
+}
+
+void cRulePlan::ScanPast(void)
+{
+	m_PastInput = m_PastOutput = false;
+	m_InputBack = m_OutputBack = 0;
+
+	for (unsigned int i = 0; i < m_Steps.Count(); i++)
+	{
+		const t_Step & step = m_Steps[i];
+
+		if (step.op == OP_PAST_INPUT)
+		{
+			m_PastInput = true;
+			m_InputBack = (step.back > m_InputBack) ? step.back : m_InputBack;
+		}
+		else if (step.op == OP_PAST_OUTPUT)
+		{
+			m_PastOutput = true;
+			m_OutputBack = (step.back > m_OutputBack) ? step.back : m_OutputBack;
+		}
+	}
+}
+
+void cRulePlan::Emit(arg::cArrayConst<t_Node> & nodes, const int id, unsigned int & depth, unsigned int & max_depth)
+{
+	t_Node & node = nodes[id];
+	t_Step step;
+
+	// a value computed before comes from its register
+	if (node.reg >= 0)
+	{
+		step.op = OP_LOAD;
+		step.value = node.reg;
+		m_Steps.Append(step);
+
+		if (++depth > max_depth)
+			max_depth = depth;
+		return;
+	}
+
+	// the operands in the original order, the result is pushed by the terminals only
+	if (node.left >= 0)
+		Emit(nodes, node.left, depth, max_depth);
+	if (node.right >= 0)
+	{
+		Emit(nodes, node.right, depth, max_depth);
+		depth--;
+	}
+	else if (node.left < 0 && ++depth > max_depth)
+	{
+		max_depth = depth;
+	}
+
+	m_Steps.Append(node.step);
+
+	if (node.uses > 1)
+	{
+		node.reg = m_RegisterCount++;
+		step.op = OP_SAVE;
+		step.value = node.reg;
+		m_Steps.Append(step);
+	}
+}
+
+void cRulePlan::Print(void) const
+{
+	static const char * names[] = {"t", "t", "o", "not", "and", "or", "sum", "prod", "thr"};
+
+	for (unsigned int i = 0; i < m_Steps.Count(); i++)
+	{
+		const t_Step & step = m_Steps[i];
+
+		switch (step.op)
+		{
+		case OP_LOAD:
+			std::cout << "r" << step.value << " ";
+			break;
+		case OP_SAVE:
+			std::cout << "=r" << step.value << " ";
+			break;
+		case OP_INPUT:
+			std::cout << names[step.op] << step.value << ":" << step.a << " ";
+			break;
+		case OP_PAST_INPUT:
+		case OP_PAST_OUTPUT:
+			std::cout << names[step.op] << step.value << "[" << step.back << "]:" << step.a << " ";
+			break;
+		default:
+			std::cout << names[step.op] << ":" << step.a << " ";
+			break;
+		}
+	}
+}
+
+// exact literal of a double, or of the nearest float
+static const char * HexLiteral(char * buff, const size_t size, const double val, const bool single)
+{
+	if (single)
+		snprintf(buff, size, "%af", (double) (float) val);
+	else
+		snprintf(buff, size, "%a", val);
+	return buff;
+}
+
+void cRulePlan::Source(std::ostream & out, const char * name, const bool single, const bool local) const
+{
+	const char * type = single ? "float" : "double";
+
+	// every step defines a new variable, the stack and the registers hold their numbers
+	arg::cArrayConst<unsigned int> stack;
+	arg::cArrayConst<unsigned int> regs;
+	char a[64], P_a[64], Q_a[64], one_minus_a[64], d[256];
+
+	out << "static inline " << type << " threshold(const " << type << " d, const " << type << " a, const " << type << " P_a, const "
+			<< type << " Q_a, const " << type << " one_minus_a)\n";
+	out << "{\n";
+	out << "\tif (a > d)\n";
+	out << "\t\treturn (" << type << ") (P_a * d) / a;\n";
+	out << "\telse\n";
+	out << "\t\treturn P_a + Q_a * ((" << type << ") (d - a) / one_minus_a);\n";
+	out << "}\n\n";
+
+	out << (local ? "static " : "") << type << " " << name << "(const " << type << " * input, const unsigned int row_idx, const "
+			<< type << " * estimate)\n";
+	out << "{\n";
+	out << "\t(void) row_idx;\n";
+	out << "\t(void) estimate;\n";
+
+	for (unsigned int i = 0; i < m_Steps.Count(); i++)
+	{
+		const t_Step & step = m_Steps[i];
+
+		// the operands as in Run, a is the top of the stack
+		unsigned int x = 0, y = 0;
+		if (step.op == OP_NOT || step.op == OP_THRESHOLD)
+		{
+			x = stack[stack.Count() - 1];
+			stack.Left(stack.Count() - 1);
+		}
+		else if (step.op >= OP_AND && step.op <= OP_PROD)
+		{
+			x = stack[stack.Count() - 1];
+			y = stack[stack.Count() - 2];
+			stack.Left(stack.Count() - 2);
+		}
+
+		switch (step.op)
+		{
+		case OP_LOAD:
+			stack.Append(regs[step.value]);
+			continue;
+		case OP_SAVE:
+			// the registers are numbered in the order of their saves
+			regs.Append(stack[stack.Count() - 1]);
+			continue;
+		case OP_INPUT:
+			snprintf(d, sizeof(d), "input[%u]", step.value);
+			break;
+		case OP_PAST_INPUT:
+			snprintf(d, sizeof(d), "(row_idx > %uu) ? (input + %d)[%u] : input[%u]", step.back, step.offset, step.value, step.value);
+			break;
+		case OP_PAST_OUTPUT:
+			if (m_InputLen == 0)
+				snprintf(d, sizeof(d), "(row_idx > %uu) ? (estimate + %d)[%u] : input[%u]", step.back, step.offset, step.value, step.value);
+			else
+				snprintf(d, sizeof(d), "(row_idx > %uu) ? (estimate + %d)[%u] : 0", step.back, step.offset, step.value);
+			break;
+		case OP_NOT:
+			snprintf(d, sizeof(d), "1 - v%u", x);
+			break;
+		case OP_AND:
+			snprintf(d, sizeof(d), "(v%u < v%u) ? v%u : v%u", x, y, x, y);
+			break;
+		case OP_OR:
+			snprintf(d, sizeof(d), "(v%u < v%u) ? v%u : v%u", x, y, y, x);
+			break;
+		case OP_SUM:
+			snprintf(d, sizeof(d), "v%u + v%u - v%u * v%u", x, y, x, y);
+			break;
+		case OP_PROD:
+			snprintf(d, sizeof(d), "v%u * v%u", x, y);
+			break;
+		case OP_THRESHOLD:
+			snprintf(d, sizeof(d), "v%u", x);
+			break;
+		}
+
+		out << "\tconst " << type << " v" << i << " = threshold(" << d << ", " << HexLiteral(a, sizeof(a), step.a, single) << ", "
+				<< HexLiteral(P_a, sizeof(P_a), step.P_a, single) << ", " << HexLiteral(Q_a, sizeof(Q_a), step.Q_a, single) << ", "
+				<< HexLiteral(one_minus_a, sizeof(one_minus_a), step.one_minus_a, single) << ");\n";
+		stack.Append(i);
+	}
+
+	out << "\treturn v" << stack[stack.Count() - 1] << ";\n";
+	out << "}\n";
+}
+
+cRulePlan::~cRulePlan(void)
+{
+	delete[] m_Operands;
+	delete[] m_Registers;
+}
@@ -0,0 +1,207 @@
+/**
+ * \class cRulePlan
+ * \brief A rule compiled for the repeated evaluation on every simulated row.
+ *
+ * The RPN instructions of one rule are translated into a compact NOOP-free list of steps
+ * with the coefficients of the fuzzy threshold precomputed from the weights. The steps are
+ * run by a plain switch on a fixed-size operand array, without virtual calls, so a rule
+ * is interpreted only once per evaluation instead of once per row.
+ *
+ * The arithmetic is the same as in cEFRModel::FuzzyThreshold, the results are bitwise equal.
+ *
+ * A simplified plan is a DAG instead of a tree: identical subexpressions (the same
+ * instruction, weight and operands) are computed once per row, kept in a register and
+ * loaded where they occur again. and(x, x) and or(x, x) reduce to the threshold of x and a
+ * past input of 0 rows back to the input. Each rewrite gives bitwise the same output. The
+ * other identities of the crisp logic do not hold, because every node thresholds its
+ * result (not(not(x)) is a different function of x than x).
+ */
+
+#ifndef CRULEPLAN_H_
+#define CRULEPLAN_H_
+
+#include "../cModel.h"
+
+#include <arg/core/cArray.h>
+
+#include <ostream>
+
+class cRulePlan
+{
+		typedef enum {
+			OP_INPUT = 0,
+			OP_PAST_INPUT,
+			OP_PAST_OUTPUT,
+			OP_NOT,
+			OP_AND,
+			OP_OR,
+			OP_SUM,
+			OP_PROD,
+			OP_THRESHOLD, ///< threshold of the operand only, and(x, x) or or(x, x)
+			OP_LOAD,      ///< push a register
+			OP_SAVE,      ///< copy the top of the stack to a register
+		} t_Op;
+
+		struct t_Step
+		{
+			t_Op op;
+			unsigned int value;    ///< input, target or register index
+			unsigned int back;     ///< rows back for the past instructions
+			int offset;            ///< offset of the past value from the current row
+			double a;              ///< the weight
+			double P_a;            ///< (1 + a) / 2
+			double Q_a;            ///< (1 - a^2) / 4
+			double one_minus_a;    ///< 1 - a
+		};
+
+		// a value of the simplified rule, the operands are indices of earlier nodes (-1 if none)
+		struct t_Node
+		{
+			t_Step step;
+			int left;
+			int right;
+			unsigned int uses;
+			int reg;
+		};
+
+		arg::cArrayConst<t_Step> m_Steps;
+
+		double * m_Operands;
+		unsigned int m_Capacity;
+
+		double * m_Registers;
+		unsigned int m_RegisterCapacity;
+		unsigned int m_RegisterCount;
+
+		unsigned int m_InputLen;
+
+		bool m_PastInput;  ///< the rule reads inputs of previous rows
+		bool m_PastOutput; ///< the rule reads its own previous outputs
+		unsigned int m_InputBack;  ///< most rows back the rule reads its inputs
+		unsigned int m_OutputBack; ///< most rows back the rule reads its outputs
+
+		inline double Threshold(const t_Step & step, const double d) const;
+
+		/** Rewrite the compiled steps as a DAG of distinct values, \returns The stack depth it needs. */
+		unsigned int Simplify(void);
+		static bool SameValue(const t_Node & node, const t_Step & step, const int left, const int right);
+		void Emit(arg::cArrayConst<t_Node> & nodes, const int id, unsigned int & depth, unsigned int & max_depth);
+		/** Find the past values the compiled steps read. */
+		void ScanPast(void);
+
+	public:
+		cRulePlan(void);
+
+		/**
+		 * Compile a rule for data rows of given width (inputs + targets), optionally simplified.
+		 * \returns False if the rule is not a well-formed expression.
+		 */
+		bool Compile(const t_Instruction * start, const unsigned int len, const unsigned int row_width, const unsigned int input_len, const bool simplify = false);
+
+		/** Evaluate the rule on a row, estimate points to the output of the row. */
+		inline double Run(const double * input, const unsigned int row_idx, const double * estimate);
+
+		unsigned int Steps(void) const {return m_Steps.Count();};
+		bool PastInput(void) const {return m_PastInput;};
+		bool PastOutput(void) const {return m_PastOutput;};
+		/** \returns The number of rows of inputs (outputs) the rule needs, the current one included. */
+		unsigned int InputDepth(void) const {return m_InputBack + 1;};
+		unsigned int OutputDepth(void) const {return m_OutputBack + 1;};
+
+		/** Print the steps in the syntax of the rules, r<i> loads and =r<i> saves a register. */
+		void Print(void) const;
+
+		/**
+		 * Write the plan as a C function type name(const type * input, const unsigned int row_idx,
+		 * const type * estimate) with the semantics of Run (static if local). In double the weights
+		 * are written exactly (as hexadecimal floats), built without contracted or reassociated
+		 * arithmetic it gives bitwise the same outputs. In float it approximates them.
+		 */
+		void Source(std::ostream & out, const char * name, const bool single = false, const bool local = false) const;
+
+		~cRulePlan(void);
+};
+
+inline double cRulePlan::Threshold(const t_Step & step, const double d) const
+{
+	// the same operations as cEFRModel::FuzzyThreshold
+	if (step.a > d)
+		return (double) (step.P_a * d) / step.a;
+	else
+		return step.P_a + step.Q_a * ((double) (d - step.a) / step.one_minus_a);
+}
+
+inline double cRulePlan::Run(const double * input, const unsigned int row_idx, const double * estimate)
+{
+	double * top = m_Operands - 1;
+	const unsigned int count = m_Steps.Count();
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const t_Step & step = m_Steps[i];
+
+		switch (step.op)
+		{
+		case OP_INPUT:
+			*(++top) = Threshold(step, input[step.value]);
+			break;
+		case OP_PAST_INPUT:
+			*(++top) = Threshold(step, (row_idx > step.back) ? (input + step.offset)[step.value] : input[step.value]);
+			break;
+		case OP_PAST_OUTPUT:
+		{
+			double val = 0.0;
+			if (row_idx > step.back)
+				val = (estimate + step.offset)[step.value];
+			else if (m_InputLen == 0)
+				val = input[step.value]; // a pure time-series ...
+			*(++top) = Threshold(step, val);
+			break;
+		}
+		case OP_NOT:
+			*top = Threshold(step, 1 - *top);
+			break;
+		case OP_AND:
+		{
+			const double a = *(top--);
+			const double b = *top;
+			*top = Threshold(step, (a < b) ? a : b);
+			break;
+		}
+		case OP_OR:
+		{
+			const double a = *(top--);
+			const double b = *top;
+			*top = Threshold(step, (a < b) ? b : a);
+			break;
+		}
+		case OP_SUM:
+		{
+			const double a = *(top--);
+			const double b = *top;
+			// probabilistic sum
+			*top = Threshold(step, a + b - a * b);
+			break;
+		}
+		case OP_PROD:
+		{
+			const double a = *(top--);
+			const double b = *top;
+			*top = Threshold(step, a * b);
+			break;
+		}
+		case OP_THRESHOLD:
+			*top = Threshold(step, *top);
+			break;
+		case OP_LOAD:
+			*(++top) = m_Registers[step.value];
+			break;
+		case OP_SAVE:
+			m_Registers[step.value] = *top;
+			break;
+		}
+	}
+	return *top;
+}
+
+#endif /* CRULEPLAN_H_ */
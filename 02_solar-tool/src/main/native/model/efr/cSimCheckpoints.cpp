@@ -0,0 +1,55 @@
+#include "cSimCheckpoints.h"
+
+cSimCheckpoints::cSimCheckpoints(void) : m_Refs(1), m_Interval(0), m_StateSize(0), m_Length(0), m_Dataset(NULL)
+{
+}
+
+void cSimCheckpoints::Acquire(void)
+{
+	#pragma omp atomic
+	m_Refs++;
+}
+
+void cSimCheckpoints::Release(void)
+{
+	unsigned int refs;
+
+	// clones on other islands may hold the same record
+	#pragma omp atomic capture
+	refs = --m_Refs;
+
+	if (refs == 0)
+		delete this;
+}
+
+void cSimCheckpoints::Start(const cSolarMdlSim * solar, const unsigned int interval)
+{
+	m_Interval = interval;
+	m_StateSize = solar->stateSize();
+	m_Length = solar->getDataLength();
+	m_Dataset = solar->featEngPot();
+
+	m_States.ClearCount();
+	m_Decisions.ClearCount();
+
+	// one snapshot per interval, the decisions grow as they come
+	m_States.Resize((m_Length / m_Interval + 1) * m_StateSize, false);
+}
+
+bool cSimCheckpoints::Matches(const cSolarMdlSim * solar, const unsigned int interval) const
+{
+	return m_Interval == interval && m_StateSize == solar->stateSize() && m_Length == solar->getDataLength()
+			&& m_Dataset == solar->featEngPot();
+}
+
+void cSimCheckpoints::CopyPrefix(const cSimCheckpoints & other, const unsigned int snapshots)
+{
+	const unsigned int row = snapshots * other.m_Interval;
+
+	unsigned int decisions = 0;
+	while (decisions < other.Decisions() && other.Row(decisions) < row)
+		decisions++;
+
+	m_States.Add(other.m_States.GetArray(0), snapshots * m_StateSize);
+	m_Decisions.Add(other.m_Decisions.GetArray(0), decisions);
+}
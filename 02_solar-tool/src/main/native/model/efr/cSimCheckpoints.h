@@ -0,0 +1,102 @@
+/**
+ * \class cSimCheckpoints
+ * \brief Simulator snapshots and controller decisions of one fitness only run.
+ *
+ * An offspring differs from its parent in a small part of the rule, so it often makes
+ * the same transmit decisions for a long part of the year. A run records the simulator
+ * state at the start of every interval and the inputs and transmit period of every
+ * decision (every row where the simulator consumes the controller output). Another rule
+ * is then first run on the recorded inputs alone: up to its first decision with a
+ * different period the simulation would be the same, so it resumes from the last
+ * snapshot before that row (see cEFRModel::Execute).
+ *
+ * A forest shares its record with its clones, so the record is reference counted.
+ */
+
+#ifndef CSIMCHECKPOINTS_H_
+#define CSIMCHECKPOINTS_H_
+
+#include "../solarSim.h"
+
+#include <arg/core/cArray.h>
+
+class cSimCheckpoints
+{
+	public:
+		const static unsigned int INPUTS = 3;
+
+	private:
+		struct t_Decision
+		{
+			unsigned int row;
+			unsigned short period;
+			double input[INPUTS];
+		};
+
+		unsigned int m_Refs;
+
+		unsigned int m_Interval;  ///< rows between two snapshots
+		unsigned int m_StateSize; ///< doubles per snapshot
+		unsigned int m_Length;    ///< length of the simulated dataset
+		const double * m_Dataset; ///< features of the simulated dataset, shared by its simulators
+
+		arg::cArrayConst<double> m_States;
+		arg::cArrayConst<t_Decision> m_Decisions;
+
+		~cSimCheckpoints(void) {};
+
+	public:
+		/** A new record has one reference. */
+		cSimCheckpoints(void);
+
+		void Acquire(void);
+		/** Drop a reference, the last one deletes the record. */
+		void Release(void);
+
+		/** Start recording a run of a simulator (drops the previous record). */
+		void Start(const cSolarMdlSim * solar, const unsigned int interval);
+		/** \returns True if the record comes from a run of the same dataset and simulator setup. */
+		bool Matches(const cSolarMdlSim * solar, const unsigned int interval) const;
+
+		/** Save the simulator state, it has to be at the start of the next interval. */
+		inline void Snapshot(const cSolarMdlSim * solar);
+		inline void Decision(const unsigned int row, const double * input, const unsigned short period);
+
+		/** Take the snapshots before the given one and the decisions before its row from another record. */
+		void CopyPrefix(const cSimCheckpoints & other, const unsigned int snapshots);
+
+		unsigned int Interval(void) const {return m_Interval;};
+		unsigned int Snapshots(void) const {return m_StateSize ? m_States.Count() / m_StateSize : 0;};
+		const double * State(const unsigned int snapshot) const {return m_States.GetArray(snapshot * m_StateSize);};
+
+		unsigned int Decisions(void) const {return m_Decisions.Count();};
+		unsigned int Row(const unsigned int i) const {return m_Decisions.GetArray(i)->row;};
+		unsigned short Period(const unsigned int i) const {return m_Decisions.GetArray(i)->period;};
+		const double * Input(const unsigned int i) const {return m_Decisions.GetArray(i)->input;};
+};
+
+inline void cSimCheckpoints::Snapshot(const cSolarMdlSim * solar)
+{
+	const unsigned int count = m_States.Count();
+	if (count + m_StateSize > m_States.Size())
+		m_States.Resize(2 * m_States.Size() + m_StateSize, true);
+
+	solar->saveState(m_States.GetArray(count));
+	m_States.Resize(m_States.Size(), count + m_StateSize);
+}
+
+inline void cSimCheckpoints::Decision(const unsigned int row, const double * input, const unsigned short period)
+{
+	if (m_Decisions.Count() == m_Decisions.Size())
+		m_Decisions.Resize(2 * m_Decisions.Size() + 1024, true);
+
+	t_Decision decision;
+	decision.row = row;
+	decision.period = period;
+	for (unsigned int i = 0; i < INPUTS; i++)
+		decision.input[i] = input[i];
+
+	m_Decisions.Append(decision);
+}
+
+#endif /* CSIMCHECKPOINTS_H_ */
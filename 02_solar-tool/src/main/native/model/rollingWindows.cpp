@@ -0,0 +1,152 @@
+/*
+ * rollingWindows.cpp
+ */
+
+#include "rollingWindows.h"
+
+#include <cstdlib>
+
+cRollingWindows::cRollingWindows(void)
+{
+    m_windowCnt = 0;
+    m_ring = NULL;
+    m_ringLen = 0;
+    reset();
+}
+
+cRollingWindows::~cRollingWindows(void)
+{
+    free(m_ring);
+}
+
+bool cRollingWindows::addWindow(unsigned int length, unsigned int offset)
+{
+    if(length == 0 || m_windowCnt >= MAX_WINDOWS)
+        return false;
+
+    m_windows[m_windowCnt].length = length;
+    m_windows[m_windowCnt].offset = offset;
+    m_windowCnt++;
+
+    // one extra slot keeps the sample that just dropped out of the oldest window
+    if(offset + length + 1 > m_ringLen)
+    {
+        m_ringLen = offset + length + 1;
+        free(m_ring);
+        m_ring = (double*)malloc(m_ringLen*sizeof(double));
+    }
+    reset();
+    return true;
+}
+
+bool cRollingWindows::addStackedWindows(unsigned int count, unsigned int length)
+{
+    unsigned int offset = 0;
+    for(unsigned int i = 0; i < m_windowCnt; i++)
+    {
+        if(m_windows[i].offset + m_windows[i].length > offset)
+            offset = m_windows[i].offset + m_windows[i].length;
+    }
+
+    for(unsigned int i = 0; i < count; i++, offset += length)
+    {
+        if(!addWindow(length, offset))
+            return false;
+    }
+    return true;
+}
+
+void cRollingWindows::reset(void)
+{
+    for(unsigned int i = 0; i < m_windowCnt; i++)
+        m_windows[i].sum = 0;
+    for(unsigned int i = 0; i < m_ringLen; i++)
+        m_ring[i] = 0;
+    m_head = 0;
+    m_pushed = 0;
+    m_resync = m_ringLen;
+}
+
+void cRollingWindows::push(double val)
+{
+    if(m_ringLen == 0)
+        return;
+
+    m_head = (m_head + 1 < m_ringLen) ? m_head + 1 : 0;
+    m_ring[m_head] = val;
+    m_pushed++;
+
+    // the sample of age offset enters the window, the one of age offset+length leaves it
+    // (samples before the first push are zeros, so they never change the sums)
+    for(unsigned int i = 0; i < m_windowCnt; i++)
+    {
+        t_Window &win = m_windows[i];
+        win.sum += m_ageVal(win.offset) - m_ageVal(win.offset + win.length);
+    }
+
+    // bound the rounding drift of the running sums, amortized O(1) per sample
+    if(--m_resync == 0)
+    {
+        m_resyncSums();
+        m_resync = m_ringLen;
+    }
+}
+
+void cRollingWindows::saveState(double *state) const
+{
+    // the counters are far below 2^53, so they survive the conversion exactly
+    state[0] = m_head;
+    state[1] = m_pushed;
+    state[2] = m_resync;
+    for(unsigned int i = 0; i < m_windowCnt; i++)
+        state[3 + i] = m_windows[i].sum;
+    for(unsigned int i = 0; i < m_ringLen; i++)
+        state[3 + m_windowCnt + i] = m_ring[i];
+}
+
+void cRollingWindows::loadState(const double *state)
+{
+    m_head = (unsigned int)state[0];
+    m_pushed = (unsigned int)state[1];
+    m_resync = (unsigned int)state[2];
+    for(unsigned int i = 0; i < m_windowCnt; i++)
+        m_windows[i].sum = state[3 + i];
+    for(unsigned int i = 0; i < m_ringLen; i++)
+        m_ring[i] = state[3 + m_windowCnt + i];
+}
+
+double cRollingWindows::average(unsigned int window) const
+{
+    const t_Window &win = m_windows[window];
+
+    if(m_pushed <= win.offset)
+        return 0;
+
+    unsigned int cnt = m_pushed - win.offset;
+    if(cnt > win.length)
+        cnt = win.length;
+
+    return win.sum / cnt;
+}
+
+void cRollingWindows::averages(double avg[]) const
+{
+    for(unsigned int i = 0; i < m_windowCnt; i++)
+        avg[i] = average(i);
+}
+
+inline double cRollingWindows::m_ageVal(unsigned int age) const
+{
+    return m_ring[(m_head >= age) ? m_head - age : m_head + m_ringLen - age];
+}
+
+void cRollingWindows::m_resyncSums(void)
+{
+    for(unsigned int i = 0; i < m_windowCnt; i++)
+    {
+        t_Window &win = m_windows[i];
+        win.sum = 0;
+        for(unsigned int age = win.offset; age < win.offset + win.length; age++)
+            win.sum += m_ageVal(age);
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * rollingWindows.h
+ *
+ *  Rolling averages of a sample stream over a set of windows. Each window is
+ *  given by its length and its offset (age of its newest sample), so both
+ *  stacked windows (e.g. the last hour, the hour before, ...) and nested ones
+ *  (e.g. the last 1h, 6h and 24h) are possible. The samples live in one ring
+ *  buffer and every window keeps a running sum, so a step costs O(windows)
+ *  regardless of the window lengths.
+ */
+
+#ifndef SIMULATOR_ROLLINGWINDOWS_H_
+#define SIMULATOR_ROLLINGWINDOWS_H_
+
+class cRollingWindows
+{
+public:
+    const static unsigned int MAX_WINDOWS = 16;
+
+    cRollingWindows(void);
+
+    /* add a window of length samples, ending offset samples before the newest one */
+    bool addWindow(unsigned int length, unsigned int offset = 0);
+    /* add count consecutive windows of length samples, the first one ending at the newest sample */
+    bool addStackedWindows(unsigned int count, unsigned int length);
+
+    void reset(void);
+    void push(double val);
+
+    /* average of the samples available in the window, 0 if there are none */
+    double average(unsigned int window) const;
+    void averages(double avg[]) const;
+    unsigned int windows(void) const { return m_windowCnt; };
+
+    /* the running state (sums and samples) as doubles, to save and restore a simulation */
+    unsigned int stateSize(void) const { return 3 + m_windowCnt + m_ringLen; };
+    void saveState(double *state) const;
+    void loadState(const double *state);
+
+    ~cRollingWindows(void);
+
+private:
+    struct t_Window
+    {
+        unsigned int length;
+        unsigned int offset;
+        double sum;
+    };
+
+    t_Window m_windows[MAX_WINDOWS];
+    unsigned int m_windowCnt;
+
+    double *m_ring;         /* last m_ringLen samples, m_ring[m_head] is the newest */
+    unsigned int m_ringLen;
+    unsigned int m_head;
+    unsigned int m_pushed;  /* number of samples since reset */
+    unsigned int m_resync;  /* samples until the sums are recomputed */
+
+    double m_ageVal(unsigned int age) const;
+    void m_resyncSums(void);
+};
+
+#endif /* SIMULATOR_ROLLINGWINDOWS_H_ */
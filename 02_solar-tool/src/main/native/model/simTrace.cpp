@@ -0,0 +1,69 @@
+/*
+ * simTrace.cpp
+ */
+
+#include "simTrace.h"
+
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+#ifdef _MSC_VER
+    #include <malloc.h>
+#endif
+
+/* bytes of an array of len items rounded up to whole cache lines */
+static inline size_t alignedSize(size_t len, size_t item)
+{
+    return ((len*item + cSimTrace::ALIGNMENT - 1) / cSimTrace::ALIGNMENT) * cSimTrace::ALIGNMENT;
+}
+
+/* MSVC has no aligned_alloc, its aligned blocks must be released by _aligned_free */
+static inline void *alignedAlloc(size_t size)
+{
+#ifdef _MSC_VER
+    return _aligned_malloc(size, cSimTrace::ALIGNMENT);
+#else
+    return aligned_alloc(cSimTrace::ALIGNMENT, size);
+#endif
+}
+
+static inline void alignedFree(void *block)
+{
+#ifdef _MSC_VER
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+cSimTrace::cSimTrace(unsigned int length)
+{
+    const size_t dbl = alignedSize(length, sizeof(double));
+    const size_t uint = alignedSize(length, sizeof(unsigned int));
+    const size_t ushort = alignedSize(length, sizeof(unsigned short));
+    const size_t flag = alignedSize(length, sizeof(bool));
+    const size_t total = 3*dbl + 2*uint + 2*ushort + 3*flag;
+
+    m_length = length;
+    m_block = alignedAlloc((total > 0) ? total : ALIGNMENT);
+    if(m_block == NULL)
+        throw std::bad_alloc();
+
+    uint8_t *ptr = (uint8_t*)m_block;
+    engLost = (double*)ptr;             ptr += dbl;
+    engHarv = (double*)ptr;             ptr += dbl;
+    soes = (double*)ptr;                ptr += dbl;
+    buffSize = (unsigned int*)ptr;      ptr += uint;
+    buffLost = (unsigned int*)ptr;      ptr += uint;
+    nextPeriod = (unsigned short*)ptr;  ptr += ushort;
+    txPayload = (unsigned short*)ptr;   ptr += ushort;
+    failM = (bool*)ptr;                 ptr += flag;
+    failT = (bool*)ptr;                 ptr += flag;
+    failD = (bool*)ptr;
+}
+
+cSimTrace::~cSimTrace(void)
+{
+    alignedFree(m_block);
+}
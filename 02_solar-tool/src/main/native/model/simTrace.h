@@ -0,0 +1,42 @@
+/*
+ * simTrace.h
+ *
+ *  Per-step outputs of one simulation run, structure of arrays in a single
+ *  cache-aligned block. A trace is sized once for a dataset and reused by all
+ *  runs on it, every run overwrites all the steps it simulates.
+ */
+
+#ifndef SIMULATOR_SIMTRACE_H_
+#define SIMULATOR_SIMTRACE_H_
+
+class cSimTrace
+{
+public:
+    const static unsigned int ALIGNMENT = 64;
+
+    double *engLost;
+    double *engHarv;
+    double *soes;
+    unsigned int *buffSize;
+    unsigned int *buffLost;
+    unsigned short *nextPeriod;
+    unsigned short *txPayload;
+    bool *failM;
+    bool *failT;
+    bool *failD;
+
+    cSimTrace(unsigned int length);
+
+    unsigned int length(void) const { return m_length; };
+
+    ~cSimTrace(void);
+
+private:
+    void *m_block;
+    unsigned int m_length;
+
+    cSimTrace(const cSimTrace&);
+    cSimTrace& operator=(const cSimTrace&);
+};
+
+#endif /* SIMULATOR_SIMTRACE_H_ */
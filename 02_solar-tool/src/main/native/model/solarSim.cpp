@@ -8,33 +8,35 @@
 #include "solarSim.h"
 #include "modelParams.h"
 
+#include <cstring>
+
 cSolarMdlSim::cSolarMdlSim(cEfrCtrlI *efrContext)
 {
     m_efrContext = efrContext;
+    m_soesWindows.addStackedWindows(cMdlPars::EfrSoesAvgSize, cMdlPars::EfrSoesAvgSmpls);
 }
 
 cSolarMdlSim::cSolarMdlSim()
 {
     m_efrContext = NULL;
+    m_soesWindows.addStackedWindows(cMdlPars::EfrSoesAvgSize, cMdlPars::EfrSoesAvgSmpls);
 }
 
 cSolarMdlSim::~cSolarMdlSim()
 {
-    m_dataSet = NULL;
+    delete m_ownTrace;
+    m_freeDataSet();
 }
 
 void cSolarMdlSim::initSim(void)
 {
-    m_free(m_outvEngHarv);
-    m_free(m_outvEngLost);
-    m_free(m_outvSoes);
-    m_free(m_outvBuffSize);
-    m_free(m_outvNextPeriod);
-    m_free(m_outvTxPayload);
-    m_free(m_outvBuffLost);
-    m_free(m_outvFailM);
-    m_free(m_outvFailT);
-    m_free(m_outvFailD);
+    // reuse the trace, a private one is only allocated when none is attached or the dataset changed
+    if(m_fullTrace && (m_trace == NULL || m_trace->length() != m_dataSetLen))
+    {
+        delete m_ownTrace;
+        m_ownTrace = new cSimTrace(m_dataSetLen);
+        m_useTrace(m_ownTrace);
+    }
     m_setESSoc(0.5f);
     m_stepId = 0u;
     m_nextTx = 1u;
@@ -43,19 +45,67 @@ void cSolarMdlSim::initSim(void)
     m_engNewPot = 0;
     m_sysReset = false;
     m_txOk = false;
+    m_soesWindows.reset();
+
+    m_accBuffSize = 0;
+    m_accFailMDays = 0;
+    m_lastFailMDay = UINT_MAX;
+    m_traced = m_fullTrace;
+}
+
+/* Fitness only runs (false) keep just the accumulators needed by calcFitness */
+void cSolarMdlSim::fullTrace(bool enable)
+{
+    m_fullTrace = enable;
+}
 
-    m_outvEngHarv = (double*)malloc(m_dataSetLen*sizeof(double));
-    m_outvEngLost = (double*)malloc(m_dataSetLen*sizeof(double));
-    m_outvSoes = (double*)malloc(m_dataSetLen*sizeof(double));
-    m_outvBuffSize = (unsigned int*)malloc(m_dataSetLen*sizeof(unsigned int));
-    m_outvNextPeriod = (unsigned short*)malloc(m_dataSetLen*sizeof(unsigned short));
-    m_outvTxPayload = (unsigned short*)malloc(m_dataSetLen*sizeof(unsigned short));
-    m_outvBuffLost = (unsigned int*)malloc(m_dataSetLen*sizeof(unsigned int));
-    m_outvFailM = (bool*)malloc(m_dataSetLen*sizeof(bool));
-    m_outvFailT = (bool*)malloc(m_dataSetLen*sizeof(bool));
-    m_outvFailD = (bool*)malloc(m_dataSetLen*sizeof(bool));
+void cSolarMdlSim::m_checkTrace(void)
+{
+    if(!m_traced)
+        throw std::logic_error("No simulation trace, enable the full trace before the run");
+}
 
+/* Fold the step into the fitness accumulators, called once per step after the logging */
+inline void cSolarMdlSim::m_accumulate(bool meas_ok)
+{
+    m_accBuffSize += m_buffSize;
 
+    // count each day with a failed measurement once
+    if(!meas_ok)
+    {
+        unsigned int day = m_stepId / ((24*60*60)/(unsigned int)cMdlPars::T_MEAS);
+        if(day != m_lastFailMDay)
+        {
+            m_accFailMDays++;
+            m_lastFailMDay = day;
+        }
+    }
+}
+
+/* Write the outputs to a trace owned by somebody else (the evaluation context), NULL detaches it */
+void cSolarMdlSim::attachTrace(cSimTrace *trace)
+{
+    if(trace != NULL)
+    {
+        delete m_ownTrace;
+        m_ownTrace = NULL;
+    }
+    m_useTrace(trace);
+}
+
+void cSolarMdlSim::m_useTrace(cSimTrace *trace)
+{
+    m_trace = trace;
+    m_outvEngLost = (trace) ? trace->engLost : NULL;
+    m_outvEngHarv = (trace) ? trace->engHarv : NULL;
+    m_outvSoes = (trace) ? trace->soes : NULL;
+    m_outvBuffSize = (trace) ? trace->buffSize : NULL;
+    m_outvBuffLost = (trace) ? trace->buffLost : NULL;
+    m_outvNextPeriod = (trace) ? trace->nextPeriod : NULL;
+    m_outvTxPayload = (trace) ? trace->txPayload : NULL;
+    m_outvFailM = (trace) ? trace->failM : NULL;
+    m_outvFailT = (trace) ? trace->failT : NULL;
+    m_outvFailD = (trace) ? trace->failD : NULL;
 }
 
 void cSolarMdlSim::initSimEfr(void)
@@ -78,8 +128,7 @@ bool cSolarMdlSim::loadDataFile(const char *fname)
     string line, cell;
     tm *time = localtime(new time_t());
 
-    m_free(m_dataSet);
-    m_dataSetLen = 0;
+    m_freeDataSet();
 
     if(dataFile.is_open())
     {
@@ -129,19 +178,116 @@ bool cSolarMdlSim::loadDataFile(const char *fname)
     else
         retVar = false;
 
+    m_dataOwner = true;
+
     if(!retVar && m_dataSet != NULL)
     {
-        free(m_dataSet);
-        m_dataSet = NULL;
-        m_dataSetLen = 0;
+        m_freeDataSet();
+    }
+
+    if(retVar)
+    {
+        m_prepFeatures();
     }
 
     return retVar;
 }
 
+/* Use the dataset loaded by another simulator (read-only, not owned) */
+void cSolarMdlSim::shareDataSet(const cSolarMdlSim *src)
+{
+    m_freeDataSet();
+    m_dataSet = src->m_dataSet;
+    m_dataSetLen = src->m_dataSetLen;
+    m_featEngPot = src->m_featEngPot;
+    m_featEAvg = src->m_featEAvg;
+    m_dataHash = src->m_dataHash;
+    m_dataOwner = false;
+}
+
+void cSolarMdlSim::m_freeDataSet(void)
+{
+    if(m_dataOwner)
+    {
+        m_free(m_dataSet);
+        m_free(m_featEngPot);
+        m_free(m_featEAvg);
+    }
+    m_dataSet = NULL;
+    m_featEngPot = NULL;
+    m_featEAvg = NULL;
+    m_dataHash = 0;
+    m_dataSetLen = 0;
+    m_dataOwner = false;
+}
+
+/* Features that do not depend on the controller, shared by all runs on the dataset */
+void cSolarMdlSim::m_prepFeatures(void)
+{
+    int dataId, cnt;
+
+    m_featEngPot = (double*)malloc(m_dataSetLen*sizeof(double));
+    m_featEAvg = (double*)malloc(m_dataSetLen*cMdlPars::EfrEAvgSize*sizeof(double));
+
+    // the runs depend on the irradiance only, the timestamps are just printed (FNV-1a)
+    m_dataHash = 14695981039346656037ULL ^ m_dataSetLen;
+    for(unsigned int i = 0; i < m_dataSetLen; i++)
+    {
+        m_dataHash ^= m_dataSet[i].val_Pd;
+        m_dataHash *= 1099511628211ULL;
+    }
+
+    // Potential energy from PV panel (equals harvested + lost energy of any run)
+    for(unsigned int i = 0; i < m_dataSetLen; i++)
+    {
+        m_featEngPot[i] = m_dataSet[i].val_Pd * cMdlPars::S_PV * (1 - cMdlPars::k_SH) * cMdlPars::n_PV * cMdlPars::n_DCDC1 * cMdlPars::T_MEAS;
+    }
+
+    for(unsigned int i = 0; i < m_dataSetLen; i++)
+    {
+        double *eAvg = &m_featEAvg[i*cMdlPars::EfrEAvgSize];
+        dataId = i;
+        for(int eavgId = 0; eavgId < cMdlPars::EfrEAvgSize; eavgId++)
+        {
+            eAvg[eavgId] = 0;
+            cnt = 0;
+
+            for(; dataId >= 0 && cnt < cMdlPars::EfrEAvgSmpls; dataId--, cnt++)
+            {
+                eAvg[eavgId] += m_featEngPot[dataId];
+            }
+            if(cnt != 0)
+            {
+                eAvg[eavgId] /= cnt;
+            }
+            eAvg[eavgId] /= cMdlPars::EfrEAvgMaxVal;
+        }
+    }
+}
+
+unsigned long long cSolarMdlSim::paramsHash(void)
+{
+    const double pars[] = {cMdlPars::k_SH, cMdlPars::S_PV, cMdlPars::n_PV, cMdlPars::n_DCDC1, cMdlPars::C_STORE,
+        cMdlPars::n_DCDC2, cMdlPars::E_SLEEP, cMdlPars::E_NVM, cMdlPars::E_MEA, cMdlPars::E_TX8B, cMdlPars::E_TX32B,
+        cMdlPars::T_MEAS, (double)cMdlPars::Smpl_TX32B, (double)cMdlPars::Smpl_TX8B, (double)cMdlPars::T_TX_MAX,
+        (double)cMdlPars::BuffSizeMax, (double)cMdlPars::EfrSoesAvgSize, (double)cMdlPars::EfrEAvgSize,
+        (double)cMdlPars::EfrSoesAvgSmpls, (double)cMdlPars::EfrEAvgSmpls, cMdlPars::EfrEAvgMaxVal};
+
+    unsigned long long hash = 14695981039346656037ULL ^ SIM_VERSION;
+    for(unsigned int i = 0; i < sizeof(pars)/sizeof(pars[0]); i++)
+    {
+        unsigned long long bits;
+        memcpy(&bits, &pars[i], sizeof(bits));
+        hash ^= bits;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 void cSolarMdlSim::saveSimOuts(const char *fname)
 {
     char time_str[20];
+    m_checkTrace();
     std::ofstream dataOutFile(fname);
 
     dataOutFile << "Time;Pd;E_lost;E_harv;SoES;BuffSize;BuffLost;T_next;Payload;Fail_M;Fail_T;Fail_D\n";
@@ -177,7 +323,7 @@ void cSolarMdlSim::simSingleCycle(void)
          throw std::out_of_range("Simulation step out of range");
 
     // Potential energy from PV panel
-    eng_new_pot = m_dataSet[m_stepId].val_Pd * cMdlPars::S_PV * (1 - cMdlPars::k_SH) * cMdlPars::n_PV * cMdlPars::n_DCDC1 * cMdlPars::T_MEAS;
+    eng_new_pot = m_featEngPot[m_stepId];
     m_setESEng(m_esEng + eng_new_pot);
     if(m_esEng > cMdlPars::C_STORE)
     {
@@ -192,7 +338,8 @@ void cSolarMdlSim::simSingleCycle(void)
     }
 
     // sleep energy
-    m_outvFailD[m_stepId] = (m_esEng < (cMdlPars::E_SLEEP/cMdlPars::n_DCDC2));
+    if(m_fullTrace)
+        m_outvFailD[m_stepId] = (m_esEng < (cMdlPars::E_SLEEP/cMdlPars::n_DCDC2));
 
     m_setESEng(m_esEng - cMdlPars::E_SLEEP/cMdlPars::n_DCDC2);
 
@@ -212,7 +359,6 @@ void cSolarMdlSim::simSingleCycle(void)
         m_buffSize = cMdlPars::BuffSizeMax;
         m_buffLost++;
     }
-    m_outvFailM[m_stepId] = !meas_ok;
 
     // transmission evaluation
     tx_payload = 0;
@@ -247,13 +393,19 @@ void cSolarMdlSim::simSingleCycle(void)
     {
             m_setESEng(0);
     }
-    m_outvEngHarv[m_stepId] = eng_new_hrv;
-    m_outvEngLost[m_stepId] = eng_new_lost;
-    m_outvSoes[m_stepId] = m_esSoc;
-    m_outvFailT[m_stepId] = !tx_ok;
-    m_outvTxPayload[m_stepId] = tx_payload;
-    m_outvBuffLost[m_stepId] = m_buffLost;
-    m_outvBuffSize[m_stepId] = m_buffSize;
+    if(m_fullTrace)
+    {
+        m_outvEngHarv[m_stepId] = eng_new_hrv;
+        m_outvEngLost[m_stepId] = eng_new_lost;
+        m_outvSoes[m_stepId] = m_esSoc;
+        m_outvFailM[m_stepId] = !meas_ok;
+        m_outvFailT[m_stepId] = !tx_ok;
+        m_outvTxPayload[m_stepId] = tx_payload;
+        m_outvBuffLost[m_stepId] = m_buffLost;
+        m_outvBuffSize[m_stepId] = m_buffSize;
+    }
+    m_soesWindows.push(m_esSoc);
+    m_accumulate(meas_ok);
 
     //compute new TxNext
     if((tx_payload > 0) && tx_ok)
@@ -261,11 +413,11 @@ void cSolarMdlSim::simSingleCycle(void)
         m_compSoesAvg(efr_in_soesAvg);
         m_compEAvg(efr_in_eAvg);
         efr_out_Tnext = m_efrContext->efrCompute(efr_in_soesAvg, m_esSoc, efr_in_eAvg);
-        next_tx_period = (unsigned short)(efr_out_Tnext*cMdlPars::T_TX_MAX + 1);
-        next_tx_period = (next_tx_period < cMdlPars::T_TX_MAX) ? next_tx_period : cMdlPars::T_TX_MAX;
+        next_tx_period = txPeriod(efr_out_Tnext);
         m_nextTx = next_tx_period + m_stepId;
     }
-    m_outvNextPeriod[m_stepId] = next_tx_period*cMdlPars::T_MEAS;
+    if(m_fullTrace)
+        m_outvNextPeriod[m_stepId] = next_tx_period*cMdlPars::T_MEAS;
 
     // reset in this cycle?
     if(m_sysReset)
@@ -284,11 +436,11 @@ bool cSolarMdlSim::simSingleCycleEfr(double nextTx)
     unsigned short next_tx_period = 0;
     if(m_txOk)
     {
-        next_tx_period = (unsigned short)(nextTx*cMdlPars::T_TX_MAX + 1);
-        next_tx_period = (next_tx_period < cMdlPars::T_TX_MAX) ? next_tx_period : cMdlPars::T_TX_MAX;
+        next_tx_period = txPeriod(nextTx);
         m_nextTx = next_tx_period + m_stepId;
     }
-    m_outvNextPeriod[m_stepId] = next_tx_period*cMdlPars::T_MEAS;
+    if(m_fullTrace)
+        m_outvNextPeriod[m_stepId] = next_tx_period*cMdlPars::T_MEAS;
 
     // reset in this cycle?
     if(m_sysReset)
@@ -310,9 +462,74 @@ bool cSolarMdlSim::simSingleCycleEfr(double nextTx)
     return m_txOk;
 }
 
+void cSolarMdlSim::simRunEfr(void)
+{
+    double soesAvg[cMdlPars::EfrSoesAvgSize], eAvg[cMdlPars::EfrEAvgSize], soesCurr, nextTx;
+
+    initSimEfr();
+    for(unsigned int i = 0; i + 1 < m_dataSetLen; i++)
+    {
+        // the controller output is consumed only after a successful transmission
+        nextTx = 0;
+        if(ctrlrNeeded())
+        {
+            getCtrlrInputs(soesAvg, &soesCurr, eAvg);
+            nextTx = m_efrContext->efrCompute(soesAvg, soesCurr, eAvg);
+        }
+        simSingleCycleEfr(nextTx);
+    }
+    finishSimEfr();
+}
+
+unsigned short cSolarMdlSim::txPeriod(double nextTx)
+{
+    unsigned short period = (unsigned short)(nextTx*cMdlPars::T_TX_MAX + 1);
+    return (period < cMdlPars::T_TX_MAX) ? period : cMdlPars::T_TX_MAX;
+}
+
+/* Save the state before the step m_stepId, the fitness accumulators included (stateSize doubles) */
+void cSolarMdlSim::saveState(double *state) const
+{
+    state[0] = m_esSoc;
+    state[1] = m_esEng;
+    state[2] = m_stepId;
+    state[3] = m_nextTx;
+    state[4] = m_buffSize;
+    state[5] = m_buffLost;
+    state[6] = m_sysReset;
+    state[7] = m_engNewPot;
+    state[8] = m_txOk;
+    state[9] = m_measOk;
+    state[10] = (double)m_accBuffSize;
+    state[11] = m_accFailMDays;
+    state[12] = m_lastFailMDay;
+    m_soesWindows.saveState(&state[SIM_STATE_VARS]);
+}
+
+/* Continue a fitness only run from a saved state of the same dataset */
+void cSolarMdlSim::loadState(const double *state)
+{
+    m_esSoc = state[0];
+    m_esEng = state[1];
+    m_stepId = (unsigned int)state[2];
+    m_nextTx = (unsigned int)state[3];
+    m_buffSize = (unsigned int)state[4];
+    m_buffLost = (unsigned int)state[5];
+    m_sysReset = (state[6] != 0);
+    m_engNewPot = state[7];
+    m_txOk = (state[8] != 0);
+    m_measOk = (state[9] != 0);
+    m_accBuffSize = (unsigned long long)state[10];
+    m_accFailMDays = (unsigned int)state[11];
+    m_lastFailMDay = (unsigned int)state[12];
+    m_soesWindows.loadState(&state[SIM_STATE_VARS]);
+    m_traced = false;
+}
+
 void cSolarMdlSim::finishSimEfr(void)
 {
-    m_outvNextPeriod[m_stepId] = 0;
+    if(m_fullTrace)
+        m_outvNextPeriod[m_stepId] = 0;
     m_stepId++;
 }
 
@@ -323,7 +540,7 @@ void cSolarMdlSim::getCtrlrInputs(double* soesAvg, double* soesCurr, double* eAv
     *soesCurr = m_esSoc;
 }
 
-unsigned int cSolarMdlSim::getDataLength(void)
+unsigned int cSolarMdlSim::getDataLength(void) const
 {
     return m_dataSetLen;
 }
@@ -344,96 +561,36 @@ void cSolarMdlSim::m_setESSoc(double soc)
     m_esEng = soc*cMdlPars::C_STORE;
 }
 
-void cSolarMdlSim::m_free(void* ptr)
-{
-    if(ptr != NULL)
-    {
-        free(ptr);
-        ptr = NULL;
-    }
-}
-
 void cSolarMdlSim::m_compSoesAvg(double soesAvg[])
 {
-    int dataId, cnt;
-    dataId = m_stepId;
-    for (int soesAvgId = 0; soesAvgId < cMdlPars::EfrSoesAvgSize; soesAvgId++)
-    {
-        soesAvg[soesAvgId] = 0;
-        cnt = 0;
-
-        for(; dataId >= 0 && cnt < cMdlPars::EfrSoesAvgSmpls; dataId--, cnt++)
-        {
-            soesAvg[soesAvgId] += m_outvSoes[dataId];
-        }
-        if(cnt != 0)
-        {
-            soesAvg[soesAvgId] /= cnt;
-        }
-    }
+    // windows hold the SoES logged up to (and including) m_stepId
+    m_soesWindows.averages(soesAvg);
 }
 
 void cSolarMdlSim::m_compEAvg(double eAvg[])
 {
-    int dataId, cnt;
-    dataId = m_stepId;
+    // harvested + lost energy is the potential energy, see m_prepFeatures
+    const double *feat = &m_featEAvg[m_stepId*cMdlPars::EfrEAvgSize];
     for(int eavgId = 0; eavgId < cMdlPars::EfrEAvgSize; eavgId++)
     {
-        eAvg[eavgId] = 0;
-        cnt = 0;
-
-        for(; dataId >= 0 && cnt < cMdlPars::EfrEAvgSmpls; dataId--, cnt++)
-        {
-            eAvg[eavgId] += (m_outvEngHarv[dataId] + m_outvEngLost[dataId]);
-        }
-        if(cnt != 0)
-        {
-            eAvg[eavgId] /= cnt;
-        }
-        eAvg[eavgId] /= cMdlPars::EfrEAvgMaxVal;
+        eAvg[eavgId] = feat[eavgId];
     }
 }
 
 void cSolarMdlSim::calcFitness(double *p1, double *p2)
 {
-    unsigned int dayCnt, smplPerDay, startID, endID;
-    double failMday, buffSizeAvg = 0;
-    bool failM;
+    unsigned int dayCnt, smplPerDay;
 
     if(m_dataSetLen == 0)
         throw std::length_error("Zero data size");
 
-    // P1 = (avg_buff_size - 1)/BuffSizeMax
-    for(unsigned int i = 0; i < m_dataSetLen; i++)
-    {
-        buffSizeAvg += m_outvBuffSize[i];
-    }
-    buffSizeAvg /= m_dataSetLen;
-    *p1 = buffSizeAvg/cMdlPars::BuffSizeMax;
+    // P1 = avg_buff_size/BuffSizeMax
+    *p1 = ((double)m_accBuffSize / m_dataSetLen)/cMdlPars::BuffSizeMax;
 
     // P2 = FailM_day/365
-    failMday = 0;
     smplPerDay = (24*60*60)/cMdlPars::T_MEAS;
     dayCnt = (m_dataSetLen/smplPerDay)+(m_dataSetLen%smplPerDay > 0);
-    for(unsigned int i = 0; i < dayCnt; i++)
-    {
-        failM = false;
-        startID = i*smplPerDay;
-        endID = (i+1)*smplPerDay;
-        endID = (endID <= (m_dataSetLen+1)) ? endID : (m_dataSetLen+1);
-
-        for(unsigned int y = startID; y < endID; y++)
-        {
-            if(m_outvFailM[y])
-            {
-                failM = true;
-                break;
-            }
-        }
-        failMday += failM;
-    }
-    failMday /= dayCnt;
-    *p2 = failMday;
+    *p2 = (double)m_accFailMDays / dayCnt;
 }
 
 /*void cSolarMdlSim::calcFitness2(double *p1, double *p2)
@@ -450,6 +607,7 @@ void cSolarMdlSim::calcFitness(double *p1, double *p2)
 
 cSimStats* cSolarMdlSim::calcStats(void)
 {
+    m_checkTrace();
     cSimStats* stats = new cSimStats();
 
     stats->BuffSizeAvg = 0;
@@ -480,6 +638,7 @@ cSimStats* cSolarMdlSim::calcStats(void)
 
 void cSolarMdlSim::calcStats(cSimStats * stats)
 {
+    m_checkTrace();
     stats->BuffSizeAvg = 0;
     stats->FailM = 0;
     stats->FailT = 0;
@@ -509,7 +668,7 @@ void cSolarMdlSim::m_evalSolarEnergy(void)
     double eng_new_lost, eng_new_hrv;
 
     // Potential energy from PV panel
-    m_engNewPot = m_dataSet[m_stepId].val_Pd * cMdlPars::S_PV * (1 - cMdlPars::k_SH) * cMdlPars::n_PV * cMdlPars::n_DCDC1 * cMdlPars::T_MEAS;
+    m_engNewPot = m_featEngPot[m_stepId];
     m_setESEng(m_esEng + m_engNewPot);
 
     if(m_esEng > cMdlPars::C_STORE)
@@ -527,11 +686,14 @@ void cSolarMdlSim::m_evalSolarEnergy(void)
         eng_new_hrv = m_engNewPot;
         eng_new_lost = 0;
     }
-    m_outvEngHarv[m_stepId] = eng_new_hrv;
-    m_outvEngLost[m_stepId] = eng_new_lost;
+    if(m_fullTrace)
+    {
+        m_outvEngHarv[m_stepId] = eng_new_hrv;
+        m_outvEngLost[m_stepId] = eng_new_lost;
 
-    // sleep energy
-    m_outvFailD[m_stepId] = (m_esEng < (cMdlPars::E_SLEEP/cMdlPars::n_DCDC2));
+        // sleep energy
+        m_outvFailD[m_stepId] = (m_esEng < (cMdlPars::E_SLEEP/cMdlPars::n_DCDC2));
+    }
 
     m_setESEng(m_esEng - cMdlPars::E_SLEEP/cMdlPars::n_DCDC2);
 
@@ -555,7 +717,9 @@ void cSolarMdlSim::m_evalMeas(void)
         m_buffSize = cMdlPars::BuffSizeMax;
         m_buffLost++;
     }
-    m_outvFailM[m_stepId] = !meas_ok;
+    if(m_fullTrace)
+        m_outvFailM[m_stepId] = !meas_ok;
+    m_measOk = meas_ok;
 }
 
 void cSolarMdlSim::m_evalTransmit(void)
@@ -586,16 +750,24 @@ void cSolarMdlSim::m_evalTransmit(void)
         }
     }
 
-    m_outvSoes[m_stepId] = m_esSoc;
     m_txOk = tx_ok && (tx_payload > 0);
-    m_outvTxPayload[m_stepId] = tx_payload;
-    m_outvFailT[m_stepId] = !tx_ok;
+    if(m_fullTrace)
+    {
+        m_outvSoes[m_stepId] = m_esSoc;
+        m_outvTxPayload[m_stepId] = tx_payload;
+        m_outvFailT[m_stepId] = !tx_ok;
+    }
 }
 
 void cSolarMdlSim::m_evalLogging(void)
 {
-    m_outvBuffLost[m_stepId] = m_buffLost;
+    if(m_fullTrace)
+    {
+        m_outvBuffLost[m_stepId] = m_buffLost;
 
-    m_outvBuffSize[m_stepId] = m_buffSize;
-    m_outvSoes[m_stepId] = m_esSoc;
+        m_outvBuffSize[m_stepId] = m_buffSize;
+        m_outvSoes[m_stepId] = m_esSoc;
+    }
+    m_soesWindows.push(m_esSoc);
+    m_accumulate(m_measOk);
 }
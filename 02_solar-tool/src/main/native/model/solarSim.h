@@ -12,6 +12,12 @@
 #include <ctime>
 #include <sstream>
 #include <iostream>
+#include <cstdlib>
+#include <climits>
+#include <stdexcept>
+
+#include "rollingWindows.h"
+#include "simTrace.h"
 
 using namespace std;
 
@@ -61,14 +67,31 @@ public:
     void initSim(void);
     void initSimEfr(void);
     bool loadDataFile(const char *fname);
+    void shareDataSet(const cSolarMdlSim *src);
+    void attachTrace(cSimTrace *trace);
+    void fullTrace(bool enable);
+    bool fullTrace(void) const { return m_fullTrace; };
     void saveSimOuts(const char *fname);
     void simRun(void);
     void simSingleCycle(void);
     bool simSingleCycleEfr(double nextTx);
+    void simRunEfr(void);  /* the EFR cycles with the controller of the constructor, as the GA runs them */
     void finishSimEfr(void);
     void getCtrlrInputs(double* soesAvg, double* soesCurr, double* eAvg);
-    unsigned int getDataLength(void);
+    bool ctrlrNeeded(void) const { return m_txOk; };  /* the next cycle uses the controller output */
+    bool simFinished(void) const { return m_stepId >= m_dataSetLen; };  /* false after a stopped run */
+    unsigned int getDataLength(void) const;
+    const double* featEngPot(void) const { return m_featEngPot; };
+    const double* featEAvg(void) const { return m_featEAvg; };
+    unsigned long long dataHash(void) const { return m_dataHash; };  /* content of the dataset */
+    static unsigned long long paramsHash(void);  /* the simulator version and cMdlPars */
     void calcFitness(double *p1, double *p2);
+    /* the run state between two steps, see cSimCheckpoints */
+    unsigned int stateSize(void) const { return SIM_STATE_VARS + m_soesWindows.stateSize(); };
+    void saveState(double *state) const;
+    void loadState(const double *state);
+    /* transmit period (in steps) the simulator makes of a controller output */
+    static unsigned short txPeriod(double nextTx);
     void calcFitness2(double *p1, double *p2);
     cSimStats* calcStats(void);
     void calcStats(cSimStats*);
@@ -78,6 +101,8 @@ public:
 private:
 
     const char m_dataFileDelimiter = ';';
+    const static unsigned int SIM_STATE_VARS = 13;
+    const static unsigned int SIM_VERSION = 1;  /* bump when a change of the model changes the results */
     cEfrCtrlI *m_efrContext;
 
     struct t_DataRow
@@ -88,6 +113,15 @@ private:
 
     t_DataRow *m_dataSet = NULL;
     unsigned int m_dataSetLen = 0;
+    bool m_dataOwner = false;
+
+    /* controller independent features, precomputed at load time */
+    double *m_featEngPot = NULL;    /* potential PV energy per step */
+    double *m_featEAvg = NULL;      /* EfrEAvgSize eAvg inputs per step */
+    unsigned long long m_dataHash = 0;
+
+    /* running SoES averages for the controller inputs */
+    cRollingWindows m_soesWindows;
 
     /* sim vars */
     double m_esSoc;
@@ -99,8 +133,18 @@ private:
     bool m_sysReset;
     double m_engNewPot;
     bool m_txOk;
-
-    /* out vars */
+    bool m_measOk;
+
+    /* fitness accumulators, kept in both modes */
+    unsigned long long m_accBuffSize;
+    unsigned int m_accFailMDays;
+    unsigned int m_lastFailMDay;
+
+    /* out vars, views of the trace (attached or owned), written only in the full trace mode */
+    bool m_fullTrace = true;
+    bool m_traced = false;
+    cSimTrace *m_trace = NULL;
+    cSimTrace *m_ownTrace = NULL;
     double *m_outvEngLost = NULL;
     double *m_outvEngHarv = NULL;
     double *m_outvSoes = NULL;
@@ -115,7 +159,12 @@ private:
 
     void m_setESEng(double eng);
     void m_setESSoc(double soc);
-    void m_free(void* ptr);
+    template<typename T> void m_free(T* &ptr);
+    void m_useTrace(cSimTrace *trace);
+    void m_checkTrace(void);
+    void m_accumulate(bool meas_ok);
+    void m_freeDataSet(void);
+    void m_prepFeatures(void);
     void m_compSoesAvg(double soesAvg[]);
     void m_compEAvg(double eAvg[]);
     void m_evalSolarEnergy(void);
@@ -126,4 +175,13 @@ private:
 
 };
 
+template<typename T> inline void cSolarMdlSim::m_free(T* &ptr)
+{
+    if(ptr != NULL)
+    {
+        free(ptr);
+        ptr = NULL;
+    }
+}
+
 #endif /* SIMULATOR_SOLARSIM_H_ */